@@ -0,0 +1,288 @@
+#include "automorphisms.h"
+#include "logging.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <unordered_set>
+
+using namespace std;
+
+namespace {
+
+// the search gives up if the partitions along the first path take more entries
+const size_t MAX_STORED_ENTRIES = size_t(1) << 25;
+
+// An ordered partition of the vertices: cell[v] is the first position of the cell of v
+// in the order, so a cell of size k occupies the positions [cell, cell + k)
+typedef vector<int> Partition;
+
+// a node of the first path of the search tree
+struct Level {
+  // the partition before the individualization
+  Partition partition;
+  // the target cell and its individualized vertex
+  int cell;
+  int vertex;
+  // the cell sizes of the refined partition after the individualization
+  vector<int> shape;
+};
+
+class AutomorphismSearch {
+ public:
+  AutomorphismSearch(int n, const vector<pair<int, int>>& arcs, bool directed, size_t maxNodes)
+      : n(n), directed(directed), maxNodes(maxNodes), out(n), in(n) {
+    for (auto& arc : arcs) {
+      CHECK(0 <= arc.first && arc.first < n && 0 <= arc.second && arc.second < n, "incorrect arc");
+      out[arc.first].push_back(arc.second);
+      arcSet.insert(key(arc.first, arc.second));
+      if (directed) {
+        in[arc.second].push_back(arc.first);
+      } else {
+        out[arc.second].push_back(arc.first);
+        arcSet.insert(key(arc.second, arc.first));
+      }
+    }
+  }
+
+  vector<vector<int>> run(const vector<int>& colors, bool& complete) {
+    vector<vector<int>> generators;
+    complete = false;
+
+    // the first path: individualize the smallest vertex of the first non-singleton cell
+    Partition p = initialPartition(colors);
+    refine(p);
+    vector<Level> levels;
+    int cell;
+    while ((cell = targetCell(p)) >= 0) {
+      if ((levels.size() + 1) * 2 * size_t(n) > MAX_STORED_ENTRIES) {
+        return generators;
+      }
+      Level level;
+      level.partition = p;
+      level.cell = cell;
+      level.vertex = n;
+      for (int v = 0; v < n; v++) {
+        if (p[v] == cell) {
+          level.vertex = min(level.vertex, v);
+        }
+      }
+      individualize(p, level.vertex);
+      refine(p);
+      level.shape = cellSizes(p);
+      levels.push_back(level);
+    }
+    firstLeaf.assign(n, -1);
+    for (int v = 0; v < n; v++) {
+      firstLeaf[p[v]] = v;
+    }
+
+    // the orbits of the generators found so far; the generators found at the deeper
+    // levels fix the vertices individualized above them
+    vector<int> orbit(n);
+    iota(orbit.begin(), orbit.end(), 0);
+
+    for (size_t k = levels.size(); k-- > 0;) {
+      auto& level = levels[k];
+      for (int w = 0; w < n; w++) {
+        if (level.partition[w] != level.cell || find(orbit, w) == find(orbit, level.vertex)) continue;
+        if (exhausted()) return generators;
+
+        Partition q = level.partition;
+        individualize(q, w);
+        refine(q);
+        if (cellSizes(q) != level.shape) continue;
+
+        vector<int> gen = descend(q, levels, k + 1);
+        if (gen.empty()) continue;
+        generators.push_back(gen);
+        for (int v = 0; v < n; v++) {
+          orbit[find(orbit, v)] = find(orbit, gen[v]);
+        }
+      }
+    }
+    complete = !exhausted();
+    return generators;
+  }
+
+ private:
+  int n;
+  bool directed;
+  size_t maxNodes;
+  size_t nodes = 0;
+  vector<vector<int>> out;
+  vector<vector<int>> in;
+  unordered_set<uint64_t> arcSet;
+  // the vertices in the order of the first leaf
+  vector<int> firstLeaf;
+
+  uint64_t key(int u, int v) const {
+    return uint64_t(u) * uint64_t(n) + uint64_t(v);
+  }
+
+  bool exhausted() const {
+    return nodes >= maxNodes;
+  }
+
+  static int find(vector<int>& parent, int v) {
+    while (parent[v] != v) {
+      parent[v] = parent[parent[v]];
+      v = parent[v];
+    }
+    return v;
+  }
+
+  Partition initialPartition(const vector<int>& colors) const {
+    vector<int> order(n);
+    iota(order.begin(), order.end(), 0);
+    auto color = [&](int v) {
+      return colors.empty() ? 0 : colors[v];
+    };
+    sort(order.begin(), order.end(), [&](int u, int v) {
+      return color(u) < color(v);
+    });
+    Partition p(n);
+    for (int i = 0; i < n; i++) {
+      p[order[i]] = i > 0 && color(order[i]) == color(order[i - 1]) ? p[order[i - 1]] : i;
+    }
+    return p;
+  }
+
+  vector<int> cellSizes(const Partition& p) const {
+    vector<int> sizes(n, 0);
+    for (int v = 0; v < n; v++) {
+      sizes[p[v]]++;
+    }
+    return sizes;
+  }
+
+  // the first non-singleton cell or -1 if the partition is discrete
+  int targetCell(const Partition& p) const {
+    vector<int> sizes = cellSizes(p);
+    for (int c = 0; c < n; c++) {
+      if (sizes[c] > 1) return c;
+    }
+    return -1;
+  }
+
+  // v becomes a singleton cell in front of the rest of its cell
+  void individualize(Partition& p, int v) const {
+    int cell = p[v];
+    for (int u = 0; u < n; u++) {
+      if (u != v && p[u] == cell) {
+        p[u] = cell + 1;
+      }
+    }
+  }
+
+  // Splits the cells by the colours of the neighbours until the partition is equitable.
+  // A cell is split into subcells ordered by their signatures, which do not depend on
+  // the labels of the vertices; hence the refinement commutes with the automorphisms
+  void refine(Partition& p) {
+    nodes++;
+    vector<int> order(n);
+    iota(order.begin(), order.end(), 0);
+    vector<vector<int>> signature(n);
+    vector<int> sizes = cellSizes(p);
+    int cells = int(n - count(sizes.begin(), sizes.end(), 0));
+
+    while (true) {
+      for (int v = 0; v < n; v++) {
+        auto& sig = signature[v];
+        sig.clear();
+        sig.push_back(p[v]);
+        for (int u : out[v]) {
+          sig.push_back(p[u]);
+        }
+        sort(sig.begin() + 1, sig.end());
+        if (directed) {
+          sig.push_back(-1);
+          size_t start = sig.size();
+          for (int u : in[v]) {
+            sig.push_back(p[u]);
+          }
+          sort(sig.begin() + start, sig.end());
+        }
+      }
+      sort(order.begin(), order.end(), [&](int u, int v) {
+        return signature[u] < signature[v];
+      });
+
+      int newCells = 0;
+      for (int i = 0; i < n; i++) {
+        if (i == 0 || signature[order[i]] != signature[order[i - 1]]) {
+          newCells++;
+          p[order[i]] = i;
+        } else {
+          p[order[i]] = p[order[i - 1]];
+        }
+      }
+      if (newCells == cells) break;
+      cells = newCells;
+    }
+  }
+
+  // searches the subtree below a node with the shape of the first path at level k for
+  // a leaf that is equivalent to the first leaf
+  vector<int> descend(const Partition& p, const vector<Level>& levels, size_t k) {
+    if (k == levels.size()) {
+      vector<int> gen(n);
+      for (int v = 0; v < n; v++) {
+        gen[firstLeaf[p[v]]] = v;
+      }
+      return isAutomorphism(gen) ? gen : vector<int>();
+    }
+
+    for (int v = 0; v < n; v++) {
+      if (p[v] != levels[k].cell) continue;
+      if (exhausted()) break;
+
+      Partition q = p;
+      individualize(q, v);
+      refine(q);
+      if (cellSizes(q) != levels[k].shape) continue;
+
+      vector<int> gen = descend(q, levels, k + 1);
+      if (!gen.empty()) return gen;
+    }
+    return vector<int>();
+  }
+
+  bool isAutomorphism(const vector<int>& gen) const {
+    for (int u = 0; u < n; u++) {
+      for (int v : out[u]) {
+        if (arcSet.count(key(gen[u], gen[v])) == 0) return false;
+      }
+    }
+    return true;
+  }
+};
+
+}
+
+vector<vector<int>> automorphismGenerators(int n, const vector<pair<int, int>>& arcs, bool directed,
+                                           const vector<int>& colors, size_t maxNodes, bool& complete) {
+  CHECK(colors.empty() || colors.size() == size_t(n), "incorrect vertex colors");
+  AutomorphismSearch search(n, arcs, directed, maxNodes);
+  return search.run(colors, complete);
+}
+
+vector<int> automorphismOrbits(int n, const vector<vector<int>>& generators) {
+  vector<int> orbit(n);
+  iota(orbit.begin(), orbit.end(), 0);
+  // the generators are applied until nothing changes; the representatives only decrease
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (auto& gen : generators) {
+      for (int v = 0; v < n; v++) {
+        int rep = min(orbit[v], orbit[gen[v]]);
+        if (orbit[v] != rep || orbit[gen[v]] != rep) {
+          orbit[v] = orbit[gen[v]] = rep;
+          changed = true;
+        }
+      }
+    }
+  }
+  return orbit;
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// Generators of the automorphism group of a graph on vertices [0..n), found by colour
+// refinement and an individualization-refinement search in the style of nauty and bliss.
+// An automorphism maps the arcs to arcs (both directions of every edge unless the graph
+// is directed) and preserves the colours of the vertices; a generator maps v to gen[v].
+// The search stops after maxNodes refinements; the generators found until then are
+// automorphisms but they may generate a subgroup only, which is reported by 'complete'
+std::vector<std::vector<int>> automorphismGenerators(int n, const std::vector<std::pair<int, int>>& arcs, bool directed,
+                                                     const std::vector<int>& colors, size_t maxNodes, bool& complete);
+
+// orbit[v] is the smallest vertex in the orbit of v under the group of the generators
+std::vector<int> automorphismOrbits(int n, const std::vector<std::vector<int>>& generators);
@@ -0,0 +1,233 @@
+#include "cardinality.h"
+#include "logging.h"
+
+using namespace std;
+
+namespace {
+
+// at-most-one over at most this many literals is encoded pairwise by default
+const size_t MAX_AUTO_PAIRWISE = 6;
+// the size of the groups in the commander encoding
+const size_t COMMANDER_GROUP = 3;
+
+MVar negate(const MVar& v) {
+  return MVar(v.id(), !v.positive());
+}
+
+// C(n, k), capped at the given limit
+uint64_t binomial(size_t n, size_t k, uint64_t limit) {
+  if (k > n) return 0;
+  k = min(k, n - k);
+  uint64_t res = 1;
+  for (size_t i = 1; i <= k; i++) {
+    res = res * (n - k + i) / i;
+    if (res > limit) return limit + 1;
+  }
+  return res;
+}
+
+void pairwise(SATModel& model, const vector<MVar>& lits, int k) {
+  // every (k+1)-subset has a false literal
+  vector<size_t> subset(k + 1);
+  for (int i = 0; i <= k; i++) {
+    subset[i] = i;
+  }
+  while (true) {
+    MClause clause;
+    for (size_t i : subset) {
+      clause.addVar(negate(lits[i]));
+    }
+    model.addClause(clause);
+
+    // the next subset in the lexicographic order
+    int pos = k;
+    while (pos >= 0 && subset[pos] == lits.size() - (k + 1) + pos) {
+      pos--;
+    }
+    if (pos < 0) break;
+    subset[pos]++;
+    for (int i = pos + 1; i <= k; i++) {
+      subset[i] = subset[i - 1] + 1;
+    }
+  }
+}
+
+// Sinz's sequential counter: s[i][j] <=> at least j+1 of lits[0..i] are true;
+// the registers that cannot be true (j > i) are not created
+void sequential(SATModel& model, const vector<MVar>& lits, int k) {
+  size_t n = lits.size();
+  vector<vector<int>> s(n - 1);
+  for (size_t i = 0; i + 1 < n; i++) {
+    size_t width = min(size_t(k), i + 1);
+    for (size_t j = 0; j < width; j++) {
+      s[i].push_back(model.addVar());
+    }
+  }
+
+  for (size_t i = 0; i < n; i++) {
+    if (i + 1 < n) {
+      model.addClause({negate(lits[i]), MVar(s[i][0], true)});
+      for (size_t j = 0; i > 0 && j < s[i - 1].size(); j++) {
+        model.addClause({MVar(s[i - 1][j], false), MVar(s[i][j], true)});
+      }
+      for (size_t j = 1; i > 0 && j < s[i].size(); j++) {
+        model.addClause({negate(lits[i]), MVar(s[i - 1][j - 1], false), MVar(s[i][j], true)});
+      }
+    }
+    // no increment beyond k
+    if (i > 0 && s[i - 1].size() == size_t(k)) {
+      model.addClause({negate(lits[i]), MVar(s[i - 1][k - 1], false)});
+    }
+  }
+}
+
+// Klieber and Kwon's commander encoding for at-most-one
+void commander(SATModel& model, const vector<MVar>& lits) {
+  if (lits.size() <= 2 * COMMANDER_GROUP) {
+    pairwise(model, lits, 1);
+    return;
+  }
+
+  vector<MVar> commanders;
+  for (size_t start = 0; start < lits.size(); start += COMMANDER_GROUP) {
+    size_t end = min(start + COMMANDER_GROUP, lits.size());
+    if (end - start == 1) {
+      commanders.push_back(lits[start]);
+      continue;
+    }
+
+    vector<MVar> group(lits.begin() + start, lits.begin() + end);
+    pairwise(model, group, 1);
+    // the commander is true iff a literal of its group is true
+    MVar c(model.addVar(), true);
+    MClause clause(negate(c));
+    for (auto& lit : group) {
+      model.addClause({negate(lit), c});
+      clause.addVar(lit);
+    }
+    model.addClause(clause);
+    commanders.push_back(c);
+  }
+  commander(model, commanders);
+}
+
+// the true literal determines the values of ceil(log(n)) bits
+void binary(SATModel& model, const vector<MVar>& lits) {
+  int bits = 0;
+  while ((size_t(1) << bits) < lits.size()) {
+    bits++;
+  }
+  int first = model.addVar();
+  for (int b = 1; b < bits; b++) {
+    model.addVar();
+  }
+
+  for (size_t i = 0; i < lits.size(); i++) {
+    for (int b = 0; b < bits; b++) {
+      model.addClause({negate(lits[i]), MVar(first + b, (i >> b) & 1)});
+    }
+  }
+}
+
+// the outputs of a totalizer node over lits[lo..hi): out[j] is true if at least
+// j+1 of the literals are true; at most k+1 outputs are kept. The root omits the
+// output k+1, which has to be false
+vector<MVar> totalizer(SATModel& model, const vector<MVar>& lits, size_t lo, size_t hi, int k, bool root) {
+  if (hi - lo == 1) {
+    return vector<MVar>(1, lits[lo]);
+  }
+
+  size_t mid = (lo + hi) / 2;
+  vector<MVar> a = totalizer(model, lits, lo, mid, k, false);
+  vector<MVar> b = totalizer(model, lits, mid, hi, k, false);
+  size_t width = min(a.size() + b.size(), size_t(k) + 1);
+  size_t created = root ? min(width, size_t(k)) : width;
+
+  vector<MVar> out;
+  for (size_t j = 0; j < created; j++) {
+    out.push_back(MVar(model.addVar(), true));
+  }
+
+  // at least i from a and at least j from b => at least i+j
+  for (size_t i = 0; i <= a.size(); i++) {
+    for (size_t j = 0; j <= b.size(); j++) {
+      size_t sum = i + j;
+      if (sum == 0 || sum > width) continue;
+
+      MClause clause;
+      if (i > 0) clause.addVar(negate(a[i - 1]));
+      if (j > 0) clause.addVar(negate(b[j - 1]));
+      if (sum <= created) clause.addVar(out[sum - 1]);
+      model.addClause(clause);
+    }
+  }
+  return out;
+}
+
+}
+
+const vector<string>& cardinalityEncodingNames() {
+  static const vector<string> names = {"auto", "pairwise", "sequential", "commander", "binary", "totalizer"};
+  return names;
+}
+
+CardinalityEncoding parseCardinalityEncoding(const string& name) {
+  auto& names = cardinalityEncodingNames();
+  for (size_t i = 0; i < names.size(); i++) {
+    if (names[i] == name) {
+      return CardinalityEncoding(i);
+    }
+  }
+  ERROR("unknown cardinality encoding '" + name + "'");
+  return CARD_AUTO;
+}
+
+void addAtMostOne(SATModel& model, const vector<MVar>& lits, CardinalityEncoding encoding) {
+  addAtMostK(model, lits, 1, encoding);
+}
+
+void addAtMostK(SATModel& model, const vector<MVar>& lits, int k, CardinalityEncoding encoding) {
+  CHECK(k >= 1);
+  vector<MVar> open;
+  for (auto& lit : lits) {
+    if (model.knownValue(lit) >= 0) {
+      open.push_back(lit);
+    }
+  }
+  if (open.size() <= size_t(k)) {
+    return;
+  }
+
+  if (encoding == CARD_AUTO) {
+    if (k == 1) {
+      encoding = open.size() <= MAX_AUTO_PAIRWISE ? CARD_PAIRWISE : CARD_SEQUENTIAL;
+    } else {
+      // the subsets as long as there are not more of them than counter clauses
+      uint64_t counterSize = 2 * open.size() * k;
+      encoding = binomial(open.size(), k + 1, counterSize) <= counterSize ? CARD_PAIRWISE : CARD_SEQUENTIAL;
+    }
+  }
+  if (k > 1 && (encoding == CARD_COMMANDER || encoding == CARD_BINARY)) {
+    encoding = CARD_SEQUENTIAL;
+  }
+
+  switch (encoding) {
+    case CARD_PAIRWISE:
+      pairwise(model, open, k);
+      break;
+    case CARD_SEQUENTIAL:
+      sequential(model, open, k);
+      break;
+    case CARD_COMMANDER:
+      commander(model, open);
+      break;
+    case CARD_BINARY:
+      binary(model, open);
+      break;
+    case CARD_TOTALIZER:
+      totalizer(model, open, 0, open.size(), k, true);
+      break;
+    default:
+      ERROR("unsupported cardinality encoding");
+  }
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include "glucoseMain.h"
+#include "sat_model.h"
+
+#include <string>
+#include <vector>
+
+// the allowed option values in the order of the enum
+const std::vector<std::string>& cardinalityEncodingNames();
+CardinalityEncoding parseCardinalityEncoding(const std::string& name);
+
+// at most one of the literals is true; literals fixed to false are skipped
+void addAtMostOne(SATModel& model, const std::vector<MVar>& lits, CardinalityEncoding encoding);
+
+// at most k of the literals are true; literals fixed to false are skipped
+void addAtMostK(SATModel& model, const std::vector<MVar>& lits, int k, CardinalityEncoding encoding);
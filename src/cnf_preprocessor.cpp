@@ -0,0 +1,421 @@
+#include "cnf_preprocessor.h"
+#include "common.h"
+#include "logging.h"
+
+#include <algorithm>
+#include <sstream>
+
+using namespace std;
+
+namespace {
+
+// variables with more occurrences are not eliminated (unless pure)
+const size_t MAX_ELIM_OCCURS = 16;
+// the maximum length of a resolvent produced by variable elimination
+const size_t MAX_RESOLVENT_SIZE = 20;
+// the maximum number of clause comparisons in subsumption checks
+const size_t SUBSUMPTION_BUDGET = 100000000;
+const int MAX_ROUNDS = 3;
+
+// literals in a clause are sorted by variable
+bool litLess(int l, int r) {
+  int al = l > 0 ? l : -l;
+  int ar = r > 0 ? r : -r;
+  return al < ar || (al == ar && l < r);
+}
+
+// whether sorted a[0..na) is a subset of sorted b[0..nb)
+bool isSubset(const int* a, size_t na, const int* b, size_t nb) {
+  size_t j = 0;
+  for (size_t i = 0; i < na; i++) {
+    while (j < nb && litLess(b[j], a[i])) j++;
+    if (j == nb || b[j] != a[i]) return false;
+    j++;
+  }
+  return true;
+}
+
+}
+
+void ReconstructionStack::push(int witness, const int* lits, size_t size) {
+  entries.push_back(witness);
+  entries.insert(entries.end(), lits, lits + size);
+  entries.push_back(0);
+}
+
+void ReconstructionStack::extend(SatAssignment& assignment) const {
+  vector<size_t> starts;
+  for (size_t i = 0; i < entries.size(); i++) {
+    starts.push_back(i);
+    while (entries[i] != 0) i++;
+  }
+
+  auto isTrue = [&](int lit) {
+    return assignment.value((lit > 0 ? lit : -lit) - 1) == (lit > 0);
+  };
+  for (size_t k = starts.size(); k > 0; k--) {
+    size_t start = starts[k - 1];
+    bool satisfied = false;
+    for (size_t i = start + 1; entries[i] != 0 && !satisfied; i++) {
+      satisfied = isTrue(entries[i]);
+    }
+    if (!satisfied) {
+      int witness = entries[start];
+      assignment.set((witness > 0 ? witness : -witness) - 1, witness > 0);
+    }
+  }
+}
+
+void ReconstructionStack::write(ostream& out) const {
+  bool lineStart = true;
+  for (int lit : entries) {
+    out << (lineStart ? "elim " : " ") << lit;
+    lineStart = (lit == 0);
+    if (lineStart) out << "\n";
+  }
+}
+
+void ReconstructionStack::readLine(const string& line) {
+  istringstream in(line);
+  string key;
+  in >> key;
+  CHECK(key == "elim", "incorrect reconstruction line: " + line);
+  int lit;
+  size_t count = 0;
+  while (in >> lit) {
+    entries.push_back(lit);
+    count++;
+    if (lit == 0) break;
+  }
+  CHECK(count >= 2 && entries.back() == 0, "incorrect reconstruction line: " + line);
+}
+
+void CnfPreprocessor::freeze(int id) {
+  if (size_t(id + 1) >= frozen.size()) {
+    frozen.resize(id + 2, 0);
+  }
+  frozen[id + 1] = 1;
+}
+
+void CnfPreprocessor::addClause(const int* clause, size_t size) {
+  vector<int> sorted(clause, clause + size);
+  sort(sorted.begin(), sorted.end(), litLess);
+  size_t j = 0;
+  for (size_t i = 0; i < sorted.size(); i++) {
+    numVars = max(numVars, Abs(sorted[i]));
+    if (j > 0 && sorted[j - 1] == -sorted[i]) {
+      // tautology
+      return;
+    }
+    if (j == 0 || sorted[j - 1] != sorted[i]) {
+      sorted[j++] = sorted[i];
+    }
+  }
+  storeClause(sorted.data(), j);
+}
+
+uint32_t CnfPreprocessor::storeClause(const int* clause, size_t size) {
+  if (size == 0) {
+    unsat = true;
+  }
+  Clause c;
+  c.start = lits.size();
+  c.size = uint32_t(size);
+  c.deleted = false;
+  lits.insert(lits.end(), clause, clause + size);
+  clauses.push_back(c);
+  return uint32_t(clauses.size() - 1);
+}
+
+void CnfPreprocessor::buildOccurs() {
+  occurs.assign(2 * size_t(numVars) + 2, vector<uint32_t>());
+  for (uint32_t c = 0; c < clauses.size(); c++) {
+    if (clauses[c].deleted) continue;
+    const int* cl = clauseLits(c);
+    for (uint32_t i = 0; i < clauses[c].size; i++) {
+      occurs[litIndex(cl[i])].push_back(c);
+    }
+  }
+}
+
+// returns false if a conflict is found
+bool CnfPreprocessor::propagate() {
+  vector<int> queue;
+  auto assign = [&](int lit) {
+    values[Abs(lit)] = lit > 0 ? 1 : -1;
+    queue.push_back(lit);
+  };
+
+  for (uint32_t c = 0; c < clauses.size(); c++) {
+    if (clauses[c].deleted || clauses[c].size != 1) continue;
+    int lit = clauseLits(c)[0];
+    if (litValue(lit) == -1) return false;
+    if (litValue(lit) == 0) assign(lit);
+  }
+
+  for (size_t q = 0; q < queue.size(); q++) {
+    int lit = queue[q];
+    for (uint32_t c : occurs[litIndex(lit)]) {
+      clauses[c].deleted = true;
+    }
+    for (uint32_t c : occurs[litIndex(-lit)]) {
+      if (clauses[c].deleted) continue;
+      const int* cl = clauseLits(c);
+      int unassigned = 0;
+      int last = 0;
+      bool satisfied = false;
+      for (uint32_t i = 0; i < clauses[c].size && !satisfied; i++) {
+        int v = litValue(cl[i]);
+        if (v == 1) satisfied = true;
+        if (v == 0) {
+          unassigned++;
+          last = cl[i];
+        }
+      }
+      if (satisfied) {
+        clauses[c].deleted = true;
+      } else if (unassigned == 0) {
+        return false;
+      } else if (unassigned == 1) {
+        assign(last);
+        clauses[c].deleted = true;
+      }
+    }
+  }
+  return true;
+}
+
+// drops deleted and satisfied clauses and false literals
+void CnfPreprocessor::compact() {
+  vector<int> newLits;
+  vector<Clause> newClauses;
+  newLits.reserve(lits.size());
+  for (auto& c : clauses) {
+    if (c.deleted) continue;
+    Clause nc;
+    nc.start = newLits.size();
+    nc.deleted = false;
+    bool satisfied = false;
+    for (uint32_t i = 0; i < c.size && !satisfied; i++) {
+      int lit = lits[c.start + i];
+      int v = litValue(lit);
+      if (v == 1) satisfied = true;
+      if (v == 0) newLits.push_back(lit);
+    }
+    if (satisfied) {
+      newLits.resize(nc.start);
+      continue;
+    }
+    nc.size = uint32_t(newLits.size() - nc.start);
+    if (nc.size == 0) unsat = true;
+    newClauses.push_back(nc);
+  }
+  lits.swap(newLits);
+  clauses.swap(newClauses);
+  buildOccurs();
+}
+
+void CnfPreprocessor::removeDuplicates() {
+  vector<uint32_t> order;
+  for (uint32_t c = 0; c < clauses.size(); c++) {
+    if (!clauses[c].deleted) order.push_back(c);
+  }
+  auto less = [&](uint32_t l, uint32_t r) {
+    if (clauses[l].size != clauses[r].size) return clauses[l].size < clauses[r].size;
+    const int* a = clauseLits(l);
+    const int* b = clauseLits(r);
+    return lexicographical_compare(a, a + clauses[l].size, b, b + clauses[r].size);
+  };
+  sort(order.begin(), order.end(), less);
+
+  for (size_t i = 1; i < order.size(); i++) {
+    if (!less(order[i - 1], order[i])) {
+      clauses[order[i]].deleted = true;
+      removedDuplicates++;
+    }
+  }
+}
+
+void CnfPreprocessor::removeSubsumed() {
+  vector<uint32_t> order;
+  for (uint32_t c = 0; c < clauses.size(); c++) {
+    if (!clauses[c].deleted) order.push_back(c);
+  }
+  stable_sort(order.begin(), order.end(), [&](uint32_t l, uint32_t r) {
+    return clauses[l].size < clauses[r].size;
+  });
+
+  size_t budget = SUBSUMPTION_BUDGET;
+  for (uint32_t c : order) {
+    if (clauses[c].deleted) continue;
+    const int* cl = clauseLits(c);
+    size_t size = clauses[c].size;
+
+    // every clause subsumed by c contains its least frequent literal
+    int best = cl[0];
+    for (size_t i = 1; i < size; i++) {
+      if (occurs[litIndex(cl[i])].size() < occurs[litIndex(best)].size()) best = cl[i];
+    }
+
+    auto& candidates = occurs[litIndex(best)];
+    if (candidates.size() > budget) break;
+    budget -= candidates.size();
+    for (uint32_t d : candidates) {
+      if (d == c || clauses[d].deleted || clauses[d].size <= size) continue;
+      if (isSubset(cl, size, clauseLits(d), clauses[d].size)) {
+        clauses[d].deleted = true;
+        removedSubsumed++;
+      }
+    }
+  }
+}
+
+// the resolvent of two clauses on var; returns false if it is a tautology
+bool CnfPreprocessor::resolve(uint32_t pos, uint32_t neg, int var, vector<int>& resolvent) const {
+  resolvent.clear();
+  const int* a = clauseLits(pos);
+  const int* b = clauseLits(neg);
+  size_t na = clauses[pos].size, nb = clauses[neg].size;
+  size_t i = 0, j = 0;
+  while (i < na || j < nb) {
+    int lit;
+    if (j == nb || (i < na && litLess(a[i], b[j]))) {
+      lit = a[i++];
+    } else if (i == na || litLess(b[j], a[i])) {
+      lit = b[j++];
+    } else {
+      lit = a[i++];
+      j++;
+    }
+    if (Abs(lit) == var) continue;
+    if (!resolvent.empty() && resolvent.back() == -lit) return false;
+    resolvent.push_back(lit);
+  }
+  return true;
+}
+
+bool CnfPreprocessor::eliminateVar(int var) {
+  vector<uint32_t> pos, neg;
+  for (uint32_t c : occurs[litIndex(var)]) {
+    if (!clauses[c].deleted) pos.push_back(c);
+  }
+  for (uint32_t c : occurs[litIndex(-var)]) {
+    if (!clauses[c].deleted) neg.push_back(c);
+  }
+  if (pos.empty() && neg.empty()) return false;
+  bool pure = pos.empty() || neg.empty();
+  if (!pure && pos.size() + neg.size() > MAX_ELIM_OCCURS) return false;
+
+  // the elimination should not increase the number of clauses
+  vector<int> resolvents;
+  vector<size_t> sizes;
+  vector<int> resolvent;
+  for (uint32_t p : pos) {
+    for (uint32_t n : neg) {
+      if (!resolve(p, n, var, resolvent)) continue;
+      if (resolvent.size() > MAX_RESOLVENT_SIZE) return false;
+      if (sizes.size() + 1 > pos.size() + neg.size()) return false;
+      resolvents.insert(resolvents.end(), resolvent.begin(), resolvent.end());
+      sizes.push_back(resolvent.size());
+    }
+  }
+
+  for (uint32_t c : pos) {
+    stack.push(var, clauseLits(c), clauses[c].size);
+    clauses[c].deleted = true;
+  }
+  for (uint32_t c : neg) {
+    stack.push(-var, clauseLits(c), clauses[c].size);
+    clauses[c].deleted = true;
+  }
+
+  size_t offset = 0;
+  for (size_t size : sizes) {
+    uint32_t c = storeClause(resolvents.data() + offset, size);
+    for (size_t i = 0; i < size; i++) {
+      occurs[litIndex(resolvents[offset + i])].push_back(c);
+    }
+    offset += size;
+  }
+  eliminated[var] = 1;
+  eliminatedVars++;
+  return true;
+}
+
+// returns whether some variable is eliminated
+bool CnfPreprocessor::eliminate() {
+  vector<pair<size_t, int>> candidates;
+  for (int var = 1; var <= numVars; var++) {
+    if (frozen[var] || eliminated[var] || values[var] != 0) continue;
+    size_t count = occurs[litIndex(var)].size() + occurs[litIndex(-var)].size();
+    if (count > 0) candidates.push_back(make_pair(count, var));
+  }
+  sort(candidates.begin(), candidates.end());
+
+  bool changed = false;
+  for (auto& candidate : candidates) {
+    if (unsat) break;
+    changed |= eliminateVar(candidate.second);
+  }
+  return changed;
+}
+
+void CnfPreprocessor::finish(int varCount, size_t clauseCount) {
+  numVars = max(numVars, varCount);
+  values.assign(numVars + 1, 0);
+  eliminated.assign(numVars + 1, 0);
+  frozen.resize(numVars + 1, 0);
+  size_t inputClauses = clauseCount;
+
+  for (int round = 0; round < MAX_ROUNDS && !unsat; round++) {
+    buildOccurs();
+    if (!propagate()) {
+      unsat = true;
+      break;
+    }
+    compact();
+    removeDuplicates();
+    removeSubsumed();
+    if (!eliminate()) break;
+  }
+  if (!unsat) {
+    buildOccurs();
+    if (propagate()) {
+      compact();
+    } else {
+      unsat = true;
+    }
+  }
+
+  size_t fixedVars = 0;
+  size_t outputClauses = 0;
+  if (unsat) {
+    if (output != nullptr) output->addClause(nullptr, 0);
+    outputClauses = 1;
+  } else {
+    for (int var = 1; var <= numVars; var++) {
+      if (values[var] == 0 || eliminated[var]) continue;
+      int lit = values[var] > 0 ? var : -var;
+      if (output != nullptr) output->addClause(&lit, 1);
+      fixedVars++;
+    }
+    outputClauses = fixedVars;
+    for (uint32_t c = 0; c < clauses.size(); c++) {
+      if (clauses[c].deleted) continue;
+      if (output != nullptr) output->addClause(clauseLits(c), clauses[c].size);
+      outputClauses++;
+    }
+  }
+  if (output != nullptr) {
+    output->finish(numVars, outputClauses);
+  }
+
+  LOG_IF(verbose, "preprocessing: %d fixed vars, %d duplicate and %d subsumed clauses removed, %d vars eliminated",
+         int(fixedVars), int(removedDuplicates), int(removedSubsumed), int(eliminatedVars));
+  LOG_IF(verbose, "preprocessing: %d clauses reduced to %d%s", int(inputClauses), int(outputClauses), unsat ? " (unsatisfiable)" : "");
+
+  // the clauses are no longer needed
+  vector<int>().swap(lits);
+  vector<Clause>().swap(clauses);
+  vector<vector<uint32_t>>().swap(occurs);
+}
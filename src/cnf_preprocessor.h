@@ -0,0 +1,103 @@
+#pragma once
+
+#include "dimacs_io.h"
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <cstdint>
+
+// Clauses removed by variable elimination; used to extend an assignment of the
+// simplified formula to the eliminated variables
+class ReconstructionStack {
+ public:
+  // the clause contains the witness literal of the eliminated variable
+  void push(int witness, const int* lits, size_t size);
+
+  // processes the clauses in the reverse order and flips the eliminated variable
+  // of every falsified clause
+  void extend(SatAssignment& assignment) const;
+
+  bool empty() const {
+    return entries.empty();
+  }
+
+  // one line per clause: 'elim <witness> <literals> 0'
+  void write(std::ostream& out) const;
+  // parses a line written by write()
+  void readLine(const std::string& line);
+
+ private:
+  // witness, the literals of the clause and a terminating 0 for every clause
+  std::vector<int> entries;
+};
+
+// Simplifies the clauses before passing them to the next sink: unit propagation,
+// removal of duplicate and subsumed clauses, and bounded variable elimination of
+// the variables that are not frozen. The variable numbering is not changed; fixed
+// variables are kept as unit clauses
+class CnfPreprocessor : public ClauseSink {
+  CnfPreprocessor(const CnfPreprocessor&);
+  CnfPreprocessor& operator = (const CnfPreprocessor&);
+
+  struct Clause {
+    size_t start;
+    uint32_t size;
+    bool deleted;
+  };
+
+ public:
+  // the output may be null (only the reconstruction stack is computed then)
+  CnfPreprocessor(ClauseSink* output, int verbose): output(output), verbose(verbose) {}
+
+  // the variable (id from 0) is kept in the formula
+  void freeze(int id);
+
+  void addClause(const int* lits, size_t size) override;
+  void finish(int varCount, size_t clauseCount) override;
+
+  const ReconstructionStack& reconstruction() const {
+    return stack;
+  }
+
+ private:
+  ClauseSink* output;
+  int verbose;
+  int numVars = 0;
+  bool unsat = false;
+
+  std::vector<int> lits;
+  std::vector<Clause> clauses;
+  // clause indices per literal (see litIndex); may refer to deleted clauses
+  std::vector<std::vector<uint32_t>> occurs;
+  // per variable: 1, -1 or 0 if not fixed
+  std::vector<int8_t> values;
+  std::vector<char> frozen;
+  std::vector<char> eliminated;
+  ReconstructionStack stack;
+
+  size_t removedDuplicates = 0;
+  size_t removedSubsumed = 0;
+  size_t eliminatedVars = 0;
+
+  static size_t litIndex(int lit) {
+    return lit > 0 ? size_t(2 * lit) : size_t(-2 * lit + 1);
+  }
+  int litValue(int lit) const {
+    int8_t v = values[lit > 0 ? lit : -lit];
+    return lit > 0 ? v : -v;
+  }
+  const int* clauseLits(uint32_t c) const {
+    return lits.data() + clauses[c].start;
+  }
+
+  uint32_t storeClause(const int* clause, size_t size);
+  void buildOccurs();
+  bool propagate();
+  void compact();
+  void removeDuplicates();
+  void removeSubsumed();
+  bool eliminate();
+  bool eliminateVar(int var);
+  bool resolve(uint32_t pos, uint32_t neg, int var, std::vector<int>& resolvent) const;
+};
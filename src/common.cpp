@@ -155,7 +155,8 @@ bool Less(double numberA, double numberB) {
   return Compare(numberA, numberB) < 0;
 }
 
-std::mt19937 RNG;
+// per thread, so that parallel workers neither race nor depend on the scheduling
+thread_local std::mt19937 RNG;
 
 size_t Rand::setSeed() {
   return setSeed(static_cast<size_t>(time(0)));
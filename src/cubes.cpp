@@ -0,0 +1,147 @@
+#include "cubes.h"
+#include "logging.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+using namespace std;
+
+namespace {
+
+// the cubes of a worker; the owner takes them from the front and thieves from the back
+struct CubeQueue {
+  mutex lock;
+  deque<int> cubes;
+};
+
+bool takeCube(vector<CubeQueue>& queues, int worker, int& cube) {
+  {
+    lock_guard<mutex> guard(queues[worker].lock);
+    if (!queues[worker].cubes.empty()) {
+      cube = queues[worker].cubes.front();
+      queues[worker].cubes.pop_front();
+      return true;
+    }
+  }
+  for (size_t k = 1; k < queues.size(); k++) {
+    auto& victim = queues[(worker + k) % queues.size()];
+    lock_guard<mutex> guard(victim.lock);
+    if (!victim.cubes.empty()) {
+      cube = victim.cubes.back();
+      victim.cubes.pop_back();
+      return true;
+    }
+  }
+  return false;
+}
+
+const char* resultName(SatSolver::Result result) {
+  return result == SatSolver::SAT ? "SAT" : result == SatSolver::UNSAT ? "UNSAT" : "cancelled";
+}
+
+}
+
+SatSolver::Result solveCubes(SATModel& model, const vector<MVar>& splitVars, const Params& params, vector<CubeStats>& stats,
+                             function<bool()> terminate) {
+  CHECK(splitVars.size() <= 20, "at most 20 split variables are supported");
+  int cubeCount = 1 << splitVars.size();
+  int workers = max(1, min(params.threads, cubeCount));
+
+  // consecutive cubes share a prefix of the split, so they go to the same worker
+  vector<CubeQueue> queues(workers);
+  for (int c = 0; c < cubeCount; c++) {
+    queues[int64_t(c) * workers / cubeCount].cubes.push_back(c);
+  }
+  stats.assign(cubeCount, CubeStats());
+  for (int c = 0; c < cubeCount; c++) {
+    stats[c].index = c;
+  }
+
+  atomic<bool> done(false);
+  atomic<bool> failed(false);
+  mutex resultLock;
+  bool satisfiable = false;
+  LOG_IF(params.verbose, "solving %d cubes over %d split variables with %d workers...", cubeCount, int(splitVars.size()), workers);
+
+  vector<thread> threads;
+  for (int w = 0; w < workers; w++) {
+    threads.emplace_back([&, w]() {
+      try {
+        auto stopped = [&done, &terminate]() {
+          return done.load() || (terminate && terminate());
+        };
+        if (stopped()) return;
+        auto solver = createSolver(params.solver, params.seed);
+        solver->setTerminate(stopped);
+        // loading a large model takes a while, so the remaining clauses are skipped once stopped
+        size_t loaded = 0;
+        bool interrupted = false;
+        model.forEachClause([&](const int* lits, size_t size) {
+          if (interrupted || ((++loaded & 0xffff) == 0 && (interrupted = stopped()))) return;
+          solver->addClause(lits, size);
+        });
+        if (interrupted) return;
+        solver->finish(model.varCount(), model.clauseCount());
+        auto cdcl = dynamic_cast<CdclSolver*>(solver.get());
+
+        int cube;
+        while (!stopped() && takeCube(queues, w, cube)) {
+          for (size_t i = 0; i < splitVars.size(); i++) {
+            int lit = splitVars[i].lit;
+            solver->assume((cube >> i) & 1 ? lit : -lit);
+          }
+          uint64_t conflicts = cdcl ? cdcl->conflictCount() : 0;
+          auto startTime = chrono::steady_clock::now();
+          auto res = solver->solve();
+
+          auto& s = stats[cube];
+          s.worker = w;
+          s.result = res;
+          s.seconds = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+          s.conflicts = cdcl ? cdcl->conflictCount() - conflicts : 0;
+          LOG_IF(params.verbose, "cube %d/%d (worker %d): %s in %.2lf seconds, %llu conflicts",
+                 cube, cubeCount, w, resultName(res), s.seconds, (unsigned long long)s.conflicts);
+
+          if (res == SatSolver::SAT) {
+            lock_guard<mutex> guard(resultLock);
+            if (!satisfiable) {
+              satisfiable = true;
+              model.fromSolver(*solver);
+            }
+            done = true;
+          } else if (res == SatSolver::UNKNOWN) {
+            // the solver was stopped, so the remaining cubes would be cancelled as well
+            done = true;
+          }
+        }
+      } catch (...) {
+        failed = true;
+        done = true;
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  CHECK(!failed, "a cube-and-conquer worker failed");
+
+  int solved = 0;
+  double total = 0, slowest = 0;
+  for (auto& s : stats) {
+    if (s.result == SatSolver::UNKNOWN) continue;
+    solved++;
+    total += s.seconds;
+    slowest = max(slowest, s.seconds);
+  }
+  LOG_IF(params.verbose, "cubes: %d of %d solved, %.2lf seconds on average, %.2lf at most",
+         solved, cubeCount, solved > 0 ? total / solved : 0.0, slowest);
+
+  if (satisfiable) {
+    return SatSolver::SAT;
+  }
+  return solved == cubeCount ? SatSolver::UNSAT : SatSolver::UNKNOWN;
+}
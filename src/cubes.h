@@ -0,0 +1,28 @@
+#pragma once
+
+#include "glucoseMain.h"
+#include "sat_model.h"
+#include "sat_solver.h"
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// statistics of a solved (or cancelled) cube
+struct CubeStats {
+  int index = 0;
+  int worker = -1;
+  SatSolver::Result result = SatSolver::UNKNOWN;
+  double seconds = 0;
+  // conflicts of the bundled solver; 0 for external solvers
+  uint64_t conflicts = 0;
+};
+
+// Cube-and-conquer: solves the model under each of the 2^d assignments of the split
+// variables on params.threads workers. Cube c assigns split variable i to bit i of c.
+// Every worker owns a solver with the clauses of the model (kept in its arena) and a
+// deque of cubes; idle workers steal from the other deques. The first satisfiable cube
+// stops the workers and its solution is copied to the model. The workers also stop once
+// terminate() is true
+SatSolver::Result solveCubes(SATModel& model, const std::vector<MVar>& splitVars, const Params& params, std::vector<CubeStats>& stats,
+                             std::function<bool()> terminate = nullptr);
@@ -0,0 +1,251 @@
+#include "decomposition.h"
+#include "logging.h"
+
+#include <algorithm>
+#include <numeric>
+
+using namespace std;
+
+namespace {
+
+int findRoot(vector<int>& parent, int v) {
+  while (parent[v] != v) {
+    parent[v] = parent[parent[v]];
+    v = parent[v];
+  }
+  return v;
+}
+
+// the edges of every connected component, ordered by their smallest vertex
+vector<vector<int>> connectedComponents(const InputGraph& inputGraph) {
+  int n = inputGraph.nc;
+  vector<int> parent(n);
+  iota(parent.begin(), parent.end(), 0);
+  for (auto& edge : inputGraph.edges) {
+    int a = findRoot(parent, edge.first);
+    int b = findRoot(parent, edge.second);
+    parent[max(a, b)] = min(a, b);
+  }
+
+  vector<int> index(n, -1);
+  vector<vector<int>> components;
+  for (size_t i = 0; i < inputGraph.edges.size(); i++) {
+    int root = findRoot(parent, inputGraph.edges[i].first);
+    if (index[root] == -1) {
+      index[root] = int(components.size());
+      components.push_back(vector<int>());
+    }
+    components[index[root]].push_back(int(i));
+  }
+  return components;
+}
+
+// the edges of every biconnected block: an iterative Hopcroft-Tarjan search that keeps
+// the tree and back edges on a stack until the lowpoint closes a block
+vector<vector<int>> biconnectedBlocks(const InputGraph& inputGraph) {
+  int n = inputGraph.nc;
+  auto& edges = inputGraph.edges;
+  vector<vector<pair<int, int>>> adj(n);
+  for (size_t i = 0; i < edges.size(); i++) {
+    adj[edges[i].first].push_back(make_pair(edges[i].second, int(i)));
+    adj[edges[i].second].push_back(make_pair(edges[i].first, int(i)));
+  }
+
+  struct Frame {
+    int vertex;
+    int parentEdge;
+    size_t next;
+  };
+
+  vector<int> disc(n, -1);
+  vector<int> low(n, 0);
+  vector<int> edgeStack;
+  vector<vector<int>> blocks;
+  int time = 0;
+  for (int root = 0; root < n; root++) {
+    if (disc[root] != -1 || adj[root].empty()) continue;
+
+    vector<Frame> frames;
+    disc[root] = low[root] = time++;
+    frames.push_back({root, -1, 0});
+    while (!frames.empty()) {
+      Frame& f = frames.back();
+      int v = f.vertex;
+      if (f.next < adj[v].size()) {
+        int u = adj[v][f.next].first;
+        int e = adj[v][f.next].second;
+        f.next++;
+        if (e == f.parentEdge) continue;
+        if (disc[u] == -1) {
+          edgeStack.push_back(e);
+          disc[u] = low[u] = time++;
+          frames.push_back({u, e, 0});
+        } else if (disc[u] < disc[v]) {
+          // a back edge
+          edgeStack.push_back(e);
+          low[v] = min(low[v], disc[u]);
+        }
+        continue;
+      }
+
+      int parentEdge = f.parentEdge;
+      frames.pop_back();
+      if (frames.empty()) break;
+      int p = frames.back().vertex;
+      low[p] = min(low[p], low[v]);
+      if (low[v] >= disc[p]) {
+        // p separates the subtree of v: its edges form a block
+        vector<int> block;
+        while (true) {
+          int e = edgeStack.back();
+          edgeStack.pop_back();
+          block.push_back(e);
+          if (e == parentEdge) break;
+        }
+        sort(block.begin(), block.end());
+        blocks.push_back(block);
+      }
+    }
+  }
+  CHECK(edgeStack.empty(), "incorrect block decomposition");
+  return blocks;
+}
+
+}
+
+GraphPart extractPart(const InputGraph& inputGraph, const vector<int>& edgeIndices) {
+  GraphPart part;
+  part.edges = edgeIndices;
+  for (int e : edgeIndices) {
+    part.vertices.push_back(inputGraph.edges[e].first);
+    part.vertices.push_back(inputGraph.edges[e].second);
+  }
+  sort(part.vertices.begin(), part.vertices.end());
+  part.vertices.erase(unique(part.vertices.begin(), part.vertices.end()), part.vertices.end());
+
+  // the vertices keep their relative order, so the edges keep first < second
+  vector<int> local(inputGraph.nc, -1);
+  for (size_t i = 0; i < part.vertices.size(); i++) {
+    local[part.vertices[i]] = int(i);
+  }
+  vector<InputGraph::EdgeTy> edges;
+  for (int e : edgeIndices) {
+    edges.push_back(make_pair(local[inputGraph.edges[e].first], local[inputGraph.edges[e].second]));
+  }
+  part.graph = InputGraph(int(part.vertices.size()), edges);
+
+  for (size_t i = 0; i < part.vertices.size(); i++) {
+    int v = part.vertices[i];
+    auto label = inputGraph.id2label.find(v);
+    if (label != inputGraph.id2label.end()) {
+      part.graph.id2label[int(i)] = label->second;
+    }
+    auto color = inputGraph.color.find(v);
+    if (color != inputGraph.color.end()) {
+      part.graph.color[int(i)] = color->second;
+    }
+  }
+  for (int e : edgeIndices) {
+    if (inputGraph.direction.size() == inputGraph.edges.size()) {
+      part.graph.direction.push_back(inputGraph.direction[e]);
+    }
+    if (inputGraph.multiPage.size() == inputGraph.edges.size()) {
+      part.graph.multiPage.push_back(inputGraph.multiPage[e]);
+    }
+    if (!inputGraph.fixedPages.empty()) {
+      part.graph.fixedPages.push_back(inputGraph.fixedPages[e]);
+    }
+  }
+  return part;
+}
+
+vector<GraphPart> decomposeGraph(const InputGraph& inputGraph, bool splitBlocks) {
+  vector<GraphPart> parts;
+  for (auto& edges : splitBlocks ? biconnectedBlocks(inputGraph) : connectedComponents(inputGraph)) {
+    parts.push_back(extractPart(inputGraph, edges));
+  }
+  return parts;
+}
+
+Layout mergeLayouts(const InputGraph& inputGraph, const vector<GraphPart>& parts, const vector<Layout>& layouts, bool isTrack) {
+  int n = inputGraph.nc;
+  CHECK(parts.size() == layouts.size());
+  Layout layout;
+  layout.pages.assign(inputGraph.edges.size(), -1);
+  if (isTrack) {
+    layout.tracks.assign(n, 0);
+  }
+
+  vector<vector<int>> partsOf(n);
+  for (size_t p = 0; p < parts.size(); p++) {
+    auto& part = parts[p];
+    for (int v : part.vertices) {
+      partsOf[v].push_back(int(p));
+    }
+    for (size_t e = 0; e < part.edges.size(); e++) {
+      layout.pages[part.edges[e]] = layouts[p].pages[e];
+    }
+    for (size_t v = 0; isTrack && v < part.vertices.size(); v++) {
+      layout.tracks[part.vertices[v]] = layouts[p].tracks[v];
+    }
+  }
+
+  // the order of a part in input vertices, starting at the cut vertex shared with its parent
+  auto partOrder = [&](int p, int cutVertex) {
+    vector<int> order;
+    for (int v : layouts[p].order) {
+      order.push_back(parts[p].vertices[v]);
+    }
+    auto it = find(order.begin(), order.end(), cutVertex);
+    if (it != order.end()) {
+      rotate(order.begin(), it, order.end());
+    }
+    return order;
+  };
+
+  // a depth-first traversal of the block-cut trees; a vertex is followed by the blocks
+  // hanging at it, followed by the rest of its block
+  struct Frame {
+    vector<int> order;
+    size_t next;
+  };
+  vector<bool> placedPart(parts.size(), false);
+  vector<bool> placedVertex(n, false);
+  for (size_t root = 0; root < parts.size(); root++) {
+    if (placedPart[root]) continue;
+    placedPart[root] = true;
+    vector<Frame> frames;
+    frames.push_back({partOrder(int(root), -1), 0});
+    while (!frames.empty()) {
+      Frame& f = frames.back();
+      if (f.next == f.order.size()) {
+        frames.pop_back();
+        continue;
+      }
+      int v = f.order[f.next++];
+      if (placedVertex[v]) continue;
+      placedVertex[v] = true;
+      layout.order.push_back(v);
+
+      // the children are pushed in reverse, so that they are placed in the order of the parts
+      vector<int> children;
+      for (int p : partsOf[v]) {
+        if (!placedPart[p]) {
+          placedPart[p] = true;
+          children.push_back(p);
+        }
+      }
+      for (size_t i = children.size(); i-- > 0;) {
+        frames.push_back({partOrder(children[i], v), 0});
+      }
+    }
+  }
+
+  for (int v = 0; v < n; v++) {
+    if (!placedVertex[v]) {
+      layout.order.push_back(v);
+    }
+  }
+  CHECK(int(layout.order.size()) == n, "incorrect merge of the layouts");
+  return layout;
+}
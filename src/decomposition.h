@@ -0,0 +1,28 @@
+#pragma once
+
+#include "glucoseMain.h"
+
+#include <vector>
+
+// A part of the input graph that is laid out by its own model: a connected component or
+// a biconnected block. Vertex (edge) i of the part is vertices[i] (edges[i]) of the input
+struct GraphPart {
+  InputGraph graph;
+  std::vector<int> vertices;
+  std::vector<int> edges;
+};
+
+// The subgraph induced by the given edges of the input; the vertices keep their relative
+// order, labels and colours, and the edges their directions
+GraphPart extractPart(const InputGraph& inputGraph, const std::vector<int>& edgeIndices);
+
+// Splits the graph into its connected components and, if splitBlocks is set, the
+// components into their biconnected blocks (Hopcroft-Tarjan); blocks share cut vertices.
+// Isolated vertices are not in any part
+std::vector<GraphPart> decomposeGraph(const InputGraph& inputGraph, bool splitBlocks);
+
+// Merges the layouts of the parts: the components are concatenated, and the blocks are
+// nested along the block-cut tree. The layout of a child block is rotated so that its
+// cut vertex comes first and the rest is placed right after the cut vertex, which keeps
+// the stack pages valid. Isolated vertices come last (on track 0)
+Layout mergeLayouts(const InputGraph& inputGraph, const std::vector<GraphPart>& parts, const std::vector<Layout>& layouts, bool isTrack);
@@ -0,0 +1,845 @@
+#include "dimacs_io.h"
+#include "logging.h"
+
+#include "common.h"
+
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <cstdint>
+#include <cerrno>
+#include <atomic>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+const char BINARY_MAGIC[4] = {'B', 'C', 'N', 'F'};
+const char BINARY_VERSION = 1;
+const size_t BINARY_HEADER_SIZE = 24;
+
+// two-digit lookup table for integer formatting
+const char DIGIT_PAIRS[201] =
+  "0001020304050607080910111213141516171819202122232425262728293031323334353637383940414243444546474849"
+  "5051525354555657585960616263646566676869707172737475767778798081828384858687888990919293949596979899";
+
+inline char* appendInt(char* out, int value) {
+  unsigned v = unsigned(value);
+  if (value < 0) {
+    *out++ = '-';
+    v = 0u - v;
+  }
+
+  char digits[10];
+  char* end = digits + 10;
+  char* p = end;
+  while (v >= 100) {
+    unsigned r = v % 100;
+    v /= 100;
+    p -= 2;
+    memcpy(p, DIGIT_PAIRS + 2 * r, 2);
+  }
+  if (v >= 10) {
+    p -= 2;
+    memcpy(p, DIGIT_PAIRS + 2 * v, 2);
+  } else {
+    *--p = char('0' + v);
+  }
+
+  memcpy(out, p, end - p);
+  return out + (end - p);
+}
+
+inline char* appendVarint(char* out, uint64_t value) {
+  while (value >= 0x80) {
+    *out++ = char((value & 0x7f) | 0x80);
+    value >>= 7;
+  }
+  *out++ = char(value);
+  return out;
+}
+
+CnfFormat cnfFormat(const string& filename) {
+  string name = filename;
+  if (name.length() > 3 && name.substr(name.length() - 3) == ".gz") {
+    name = name.substr(0, name.length() - 3);
+  }
+  if (name.length() > 5 && name.substr(name.length() - 5) == ".bcnf") {
+    return BINARY_CNF;
+  }
+  return TEXT_CNF;
+}
+
+ParallelDeflater::ParallelDeflater(int level, int threads, function<void(const unsigned char*, size_t)> write): level(level), write(write) {
+  totalCrc = crc32(0L, Z_NULL, 0);
+
+  // with a single thread, blocks are compressed by the caller
+  if (threads > 1) {
+    for (int i = 0; i < threads; i++) {
+      workers.emplace_back(&ParallelDeflater::workerLoop, this);
+    }
+  }
+}
+
+ParallelDeflater::~ParallelDeflater() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  workAvailable.notify_all();
+  for (auto& worker : workers) {
+    worker.join();
+  }
+}
+
+void ParallelDeflater::compress(Block& block) const {
+  block.crc = crc32(0L, (const Bytef*)block.input.data(), (uInt)block.inputSize);
+
+  z_stream stream;
+  memset(&stream, 0, sizeof(stream));
+  if (deflateInit2(&stream, level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+    return;
+  }
+
+  // a sync flush adds at most an empty stored block to the bound
+  block.output.resize(deflateBound(&stream, block.inputSize) + 16);
+  stream.next_in = (Bytef*)block.input.data();
+  stream.avail_in = (uInt)block.inputSize;
+  stream.next_out = block.output.data();
+  stream.avail_out = (uInt)block.output.size();
+  int res = deflate(&stream, block.last ? Z_FINISH : Z_SYNC_FLUSH);
+  if ((block.last && res == Z_STREAM_END) || (!block.last && res == Z_OK && stream.avail_in == 0)) {
+    block.output.resize(block.output.size() - stream.avail_out);
+  } else {
+    block.output.clear();
+  }
+  deflateEnd(&stream);
+}
+
+void ParallelDeflater::workerLoop() {
+  while (true) {
+    std::shared_ptr<Block> block;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      workAvailable.wait(lock, [&]() {
+        return stopping || !pending.empty();
+      });
+      if (pending.empty()) {
+        return;
+      }
+      block = pending.front();
+      pending.pop_front();
+    }
+
+    compress(*block);
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      block->done = true;
+    }
+    blockDone.notify_all();
+  }
+}
+
+void ParallelDeflater::add(vector<char>& input, size_t size, bool last) {
+  auto block = std::make_shared<Block>();
+  vector<char> next;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!freeBuffers.empty()) {
+      next.swap(freeBuffers.back());
+      freeBuffers.pop_back();
+    }
+  }
+  next.resize(input.size());
+  block->input.swap(input);
+  input.swap(next);
+  block->inputSize = size;
+  block->last = last;
+  blocks.push_back(block);
+
+  if (workers.empty()) {
+    compress(*block);
+    block->done = true;
+    writeCompleted(0);
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    pending.push_back(block);
+  }
+  workAvailable.notify_one();
+  // bound the number of blocks (and the memory) in flight
+  writeCompleted(2 * workers.size());
+}
+
+void ParallelDeflater::finish() {
+  writeCompleted(0);
+}
+
+// writes the completed blocks from the head of the stream, waiting for the head block
+// while more than maxInFlight blocks are not written
+void ParallelDeflater::writeCompleted(size_t maxInFlight) {
+  while (!blocks.empty()) {
+    auto block = blocks.front();
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      if (!block->done && blocks.size() <= maxInFlight) {
+        return;
+      }
+      blockDone.wait(lock, [&]() {
+        return block->done;
+      });
+    }
+
+    CHECK(block->inputSize == 0 || !block->output.empty(), "zlib error");
+    write(block->output.data(), block->output.size());
+    totalCrc = crc32_combine(totalCrc, block->crc, (z_off_t)block->inputSize);
+    totalSize += block->inputSize;
+    blocks.pop_front();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    freeBuffers.push_back(std::move(block->input));
+  }
+}
+
+CnfWriter::CnfWriter(const string& filename, int compressionLevel, int threads): filename(filename) {
+  format = cnfFormat(filename);
+  compressed = filename.length() > 3 && filename.substr(filename.length() - 3) == ".gz";
+
+  file = fopen(filename.c_str(), "wb");
+  CHECK(file != nullptr, "cannot open '" + filename + "' for writing");
+  buffer.resize(BUFFER_SIZE);
+
+  if (compressed) {
+    // raw deflate; gzip header and trailer are written explicitly
+    CHECK(1 <= compressionLevel && compressionLevel <= 9, "incorrect compression level");
+    deflater.reset(new ParallelDeflater(compressionLevel, threads, [this](const unsigned char* data, size_t size) {
+      writeRaw(data, size);
+    }));
+  }
+}
+
+CnfWriter::CnfWriter(FILE* stream, const string& name): filename(name), format(TEXT_CNF), file(stream), isStream(true) {
+  CHECK(file != nullptr, "cannot write to '" + filename + "'");
+  buffer.resize(BUFFER_SIZE);
+}
+
+CnfWriter::~CnfWriter() {
+  deflater.reset();
+  if (file != nullptr && !isStream) {
+    fclose(file);
+  }
+}
+
+void CnfWriter::writeRaw(const void* data, size_t size) {
+  size_t written = fwrite(data, 1, size, file);
+  CHECK(written == size, "cannot write to '" + filename + "'");
+}
+
+// writes the gzip member header followed by a stored (uncompressed) deflate block with
+// the content, so that the content can later be overwritten in place
+void CnfWriter::writeGzipHeader(const string& content) {
+  CHECK(content.length() < 65536);
+  const unsigned char header[10] = {0x1f, 0x8b, 8, 0, 0, 0, 0, 0, 0, 3};
+  writeRaw(header, sizeof(header));
+
+  unsigned short len = (unsigned short)content.length();
+  unsigned short nlen = (unsigned short)~len;
+  const unsigned char block[5] = {0, (unsigned char)(len & 0xff), (unsigned char)(len >> 8), (unsigned char)(nlen & 0xff), (unsigned char)(nlen >> 8)};
+  writeRaw(block, sizeof(block));
+  writeRaw(content.data(), content.length());
+}
+
+// the text header is a 'p cnf' line, padded by a leading comment line if reserved;
+// the binary header has a fixed size
+string CnfWriter::header(int varCount, size_t clauseCount, bool reserved) const {
+  if (format == BINARY_CNF) {
+    string header(BINARY_HEADER_SIZE, '\0');
+    memcpy(&header[0], BINARY_MAGIC, 4);
+    header[4] = BINARY_VERSION;
+    for (int i = 0; i < 8; i++) {
+      header[8 + i] = char((uint64_t(varCount) >> (8 * i)) & 0xff);
+      header[16 + i] = char((uint64_t(clauseCount) >> (8 * i)) & 0xff);
+    }
+    return header;
+  }
+
+  string header = "p cnf " + to_string(varCount) + " " + to_string(clauseCount) + "\n";
+  if (!reserved) {
+    return header;
+  }
+
+  CHECK(header.length() + 2 <= TEXT_HEADER_SIZE, "dimacs header is too long");
+  return "c" + string(TEXT_HEADER_SIZE - header.length() - 2, ' ') + "\n" + header;
+}
+
+void CnfWriter::startFile(const string& content, bool reserved) {
+  CHECK(!headerWritten, "cnf header is already written");
+  if (compressed) {
+    writeGzipHeader(content);
+  } else {
+    writeRaw(content.data(), content.length());
+  }
+  headerSize = content.length();
+  headerWritten = true;
+  reservedHeader = reserved;
+}
+
+void CnfWriter::writeHeader(int varCount, size_t clauseCount) {
+  startFile(header(varCount, clauseCount, false), false);
+}
+
+void CnfWriter::addClause(const int* lits, size_t size) {
+  if (!headerWritten) {
+    CHECK(!isStream, "the header has to be written before the clauses to '" + filename + "'");
+    startFile(header(0, 0, true), true);
+  }
+
+  // at most 11 chars per literal plus a separator
+  size_t maxSize = 12 * (size + 1);
+  if (bufferSize + maxSize > buffer.size()) {
+    flush(false);
+    if (maxSize > buffer.size()) {
+      buffer.resize(maxSize);
+    }
+  }
+
+  char* out = buffer.data() + bufferSize;
+  if (format == TEXT_CNF) {
+    for (size_t i = 0; i < size; i++) {
+      out = appendInt(out, lits[i]);
+      *out++ = ' ';
+    }
+    *out++ = '0';
+    *out++ = '\n';
+  } else {
+    sortedLits.assign(lits, lits + size);
+    std::sort(sortedLits.begin(), sortedLits.end(), [](int l, int r) {
+      return Abs(l) < Abs(r);
+    });
+
+    out = appendVarint(out, size);
+    uint64_t prevVar = 0;
+    for (int lit : sortedLits) {
+      uint64_t var = Abs(lit);
+      out = appendVarint(out, ((var - prevVar) << 1) | (lit < 0 ? 1 : 0));
+      prevVar = var;
+    }
+  }
+  bufferSize = out - buffer.data();
+}
+
+void CnfWriter::flush(bool last) {
+  if (compressed) {
+    deflater->add(buffer, bufferSize, last);
+    if (last) {
+      deflater->finish();
+    }
+  } else {
+    writeRaw(buffer.data(), bufferSize);
+  }
+  bufferSize = 0;
+}
+
+void CnfWriter::finish(int varCount, size_t clauseCount) {
+  CHECK(!finished);
+  if (!headerWritten) {
+    writeHeader(varCount, clauseCount);
+  }
+  flush(true);
+
+  string content = header(varCount, clauseCount, reservedHeader);
+  CHECK(content.length() == headerSize, "cnf header does not match the reserved space");
+  if (reservedHeader) {
+    // gzip header (10 bytes) and stored block header (5 bytes) precede the content
+    long offset = compressed ? 15 : 0;
+    CHECK(fseek(file, offset, SEEK_SET) == 0, "cannot seek in '" + filename + "'");
+    writeRaw(content.data(), content.length());
+    CHECK(fseek(file, 0, SEEK_END) == 0, "cannot seek in '" + filename + "'");
+  }
+
+  if (compressed) {
+    uLong headerCrc = crc32(0L, (const Bytef*)content.data(), (uInt)content.length());
+    uLong totalCrc = crc32_combine(headerCrc, deflater->crc(), (z_off_t)deflater->size());
+    size_t totalSize = content.length() + deflater->size();
+    unsigned char trailer[8];
+    for (int i = 0; i < 4; i++) {
+      trailer[i] = (unsigned char)((totalCrc >> (8 * i)) & 0xff);
+      trailer[4 + i] = (unsigned char)((totalSize >> (8 * i)) & 0xff);
+    }
+    writeRaw(trailer, sizeof(trailer));
+  }
+
+  if (isStream) {
+    CHECK(fflush(file) == 0, "cannot write to '" + filename + "'");
+  } else {
+    CHECK(fclose(file) == 0, "cannot write to '" + filename + "'");
+  }
+  file = nullptr;
+  finished = true;
+}
+
+// Buffered reader on top of gzread (which also handles uncompressed files)
+class GzInput {
+  gzFile file;
+  std::vector<unsigned char> buffer;
+  size_t pos = 0;
+  size_t size = 0;
+
+ public:
+  explicit GzInput(const string& filename) {
+    file = gzopen(filename.c_str(), "rb");
+    CHECK(file != nullptr, "cannot open '" + filename + "'");
+    gzbuffer(file, 1 << 20);
+    buffer.resize(1 << 20);
+  }
+
+  ~GzInput() {
+    gzclose(file);
+  }
+
+  // returns -1 at the end of the input
+  int next() {
+    if (pos == size) {
+      int len = gzread(file, buffer.data(), (unsigned)buffer.size());
+      CHECK(len >= 0, "cannot read the input");
+      if (len == 0) {
+        return -1;
+      }
+      pos = 0;
+      size = len;
+    }
+    return buffer[pos++];
+  }
+
+  int peek() {
+    int c = next();
+    if (c != -1) {
+      pos--;
+    }
+    return c;
+  }
+
+  uint64_t readVarint() {
+    uint64_t value = 0;
+    for (int shift = 0; ; shift += 7) {
+      int c = next();
+      CHECK(c != -1 && shift < 64, "truncated binary cnf");
+      value |= uint64_t(c & 0x7f) << shift;
+      if ((c & 0x80) == 0) {
+        return value;
+      }
+    }
+  }
+
+  void skipLine() {
+    int c;
+    while ((c = next()) != -1 && c != '\n') {}
+  }
+
+  void skipSpaces() {
+    int c;
+    while ((c = peek()) == ' ' || c == '\t' || c == '\n' || c == '\r') {
+      next();
+    }
+  }
+
+  long long readInt() {
+    skipSpaces();
+    bool negative = false;
+    if (peek() == '-') {
+      negative = true;
+      next();
+    }
+    int c = peek();
+    CHECK('0' <= c && c <= '9', "unexpected character in dimacs input");
+    long long value = 0;
+    while ((c = peek()) >= '0' && c <= '9') {
+      value = value * 10 + (c - '0');
+      next();
+    }
+    return negative ? -value : value;
+  }
+};
+
+int readCnf(const string& filename, ClauseSink& sink) {
+  GzInput in(filename);
+  std::vector<int> clause;
+  int varCount = 0;
+  size_t clauseCount = 0;
+  size_t readClauses = 0;
+
+  if (cnfFormat(filename) == BINARY_CNF) {
+    unsigned char header[BINARY_HEADER_SIZE];
+    for (size_t i = 0; i < BINARY_HEADER_SIZE; i++) {
+      int c = in.next();
+      CHECK(c != -1, "truncated binary cnf '" + filename + "'");
+      header[i] = (unsigned char)c;
+    }
+    CHECK(memcmp(header, BINARY_MAGIC, 4) == 0 && header[4] == BINARY_VERSION, "incorrect binary cnf '" + filename + "'");
+    uint64_t vars = 0, clauses = 0;
+    for (int i = 0; i < 8; i++) {
+      vars |= uint64_t(header[8 + i]) << (8 * i);
+      clauses |= uint64_t(header[16 + i]) << (8 * i);
+    }
+    varCount = int(vars);
+    clauseCount = size_t(clauses);
+
+    for (; readClauses < clauseCount; readClauses++) {
+      size_t size = in.readVarint();
+      clause.resize(size);
+      uint64_t var = 0;
+      for (size_t i = 0; i < size; i++) {
+        uint64_t code = in.readVarint();
+        var += code >> 1;
+        CHECK(1 <= var && var <= vars, "incorrect literal in '" + filename + "'");
+        clause[i] = (code & 1) ? -int(var) : int(var);
+      }
+      sink.addClause(clause.data(), clause.size());
+    }
+  } else {
+    bool headerFound = false;
+    while (true) {
+      in.skipSpaces();
+      int c = in.peek();
+      if (c == -1) {
+        break;
+      }
+      if (c == 'c') {
+        in.skipLine();
+        continue;
+      }
+      if (c == 'p') {
+        in.next();
+        in.skipSpaces();
+        CHECK(in.next() == 'c' && in.next() == 'n' && in.next() == 'f', "incorrect dimacs header in '" + filename + "'");
+        varCount = int(in.readInt());
+        clauseCount = size_t(in.readInt());
+        headerFound = true;
+        continue;
+      }
+
+      CHECK(headerFound, "missing dimacs header in '" + filename + "'");
+      long long lit = in.readInt();
+      if (lit == 0) {
+        sink.addClause(clause.data(), clause.size());
+        clause.clear();
+        readClauses++;
+      } else {
+        CHECK(Abs(lit) <= varCount, "incorrect literal in '" + filename + "'");
+        clause.push_back(int(lit));
+      }
+    }
+    CHECK(clause.empty(), "unterminated clause in '" + filename + "'");
+  }
+
+  CHECK(readClauses == clauseCount, "incorrect number of clauses in '" + filename + "'");
+  sink.finish(varCount, clauseCount);
+  return varCount;
+}
+
+// Read-only memory mapping of a whole file
+class MappedFile {
+  MappedFile(const MappedFile&);
+  MappedFile& operator = (const MappedFile&);
+
+ public:
+  const char* data = nullptr;
+  size_t size = 0;
+
+  explicit MappedFile(const string& filename) {
+    int fd = open(filename.c_str(), O_RDONLY);
+    CHECK(fd >= 0, "cannot open '" + filename + "'");
+    struct stat st;
+    CHECK(fstat(fd, &st) == 0, "cannot read '" + filename + "'");
+    size = size_t(st.st_size);
+    if (size > 0) {
+      void* ptr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+      CHECK(ptr != MAP_FAILED, "cannot map '" + filename + "'");
+      madvise(ptr, size, MADV_SEQUENTIAL);
+      data = (const char*)ptr;
+    }
+    close(fd);
+  }
+
+  ~MappedFile() {
+    if (data != nullptr) {
+      munmap((void*)data, size);
+    }
+  }
+};
+
+void readAssignment(const string& filename, SatAssignment& result) {
+  MappedFile file(filename);
+  parseAssignment(file.data, file.size, "'" + filename + "'", result);
+}
+
+void parseAssignment(const char* data, size_t size, const string& source, SatAssignment& result) {
+  const char* p = data;
+  const char* end = p + size;
+  while (p < end) {
+    // at the beginning of a line
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) p++;
+    if (p == end) break;
+
+    char mode = *p++;
+    if (mode == 's') {
+      while (p < end && (*p == ' ' || *p == '\t')) p++;
+      const char* start = p;
+      while (p < end && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n') p++;
+      result.status = string(start, p);
+    } else if (mode == 'v') {
+      while (p < end && *p != '\n') {
+        if (*p == ' ' || *p == '\t' || *p == '\r') {
+          p++;
+          continue;
+        }
+
+        bool negative = false;
+        if (*p == '-') {
+          negative = true;
+          p++;
+        }
+        CHECK(p < end && '0' <= *p && *p <= '9', "unexpected character in " + source);
+        long long value = 0;
+        while (p < end && '0' <= *p && *p <= '9') {
+          value = value * 10 + (*p - '0');
+          CHECK(value <= (long long)result.size(), "incorrect variable in " + source);
+          p++;
+        }
+
+        if (value != 0) {
+          int lit = negative ? -int(value) : int(value);
+          CHECK(result.assign(lit), "duplicate variable in " + source + ": " + to_string(value));
+        }
+      }
+    }
+
+    // skip the rest of the line
+    while (p < end && *p != '\n') p++;
+  }
+
+  CHECK(result.status != "", "missing SAT status in " + source);
+}
+
+// process groups of the running solvers; plain atomic slots, since they are read by a
+// signal handler, which cannot take a lock
+const int MAX_SOLVER_GROUPS = 1024;
+std::atomic<pid_t> solverGroups[MAX_SOLVER_GROUPS];
+
+void registerSolverGroup(pid_t pid) {
+  for (auto& slot : solverGroups) {
+    pid_t empty = 0;
+    if (slot.compare_exchange_strong(empty, pid)) return;
+  }
+  // not expected with the bounded number of threads; such a solver is not killed on a signal
+}
+
+void unregisterSolverGroup(pid_t pid) {
+  for (auto& slot : solverGroups) {
+    pid_t expected = pid;
+    if (slot.compare_exchange_strong(expected, 0)) return;
+  }
+}
+
+void killSolverGroups(int sig) {
+  for (auto& slot : solverGroups) {
+    pid_t pid = slot.load();
+    if (pid > 0) kill(-pid, SIGKILL);
+  }
+  // terminate the way the default action would
+  signal(sig, SIG_DFL);
+  raise(sig);
+}
+
+void killSolversOnSignals() {
+  struct sigaction action;
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = killSolverGroups;
+  sigemptyset(&action.sa_mask);
+  // signals ignored by the parent (e.g. SIGINT of background jobs) stay ignored
+  for (int sig : {SIGINT, SIGTERM}) {
+    struct sigaction current;
+    if (sigaction(sig, nullptr, &current) == 0 && current.sa_handler != SIG_IGN) {
+      sigaction(sig, &action, nullptr);
+    }
+  }
+}
+
+SolverProcess::SolverProcess(const string& command, const string& cnfFile): command(command) {
+  int inPipe[2], outPipe[2];
+  // close-on-exec from the start, so solvers forked concurrently by other threads do not inherit the ends
+  CHECK(pipe2(inPipe, O_CLOEXEC) == 0 && pipe2(outPipe, O_CLOEXEC) == 0, "cannot create pipes for the solver");
+
+  // a signal between fork() and the registration of the group would leave the solver running
+  sigset_t blocked, previous;
+  sigemptyset(&blocked);
+  sigaddset(&blocked, SIGINT);
+  sigaddset(&blocked, SIGTERM);
+  pthread_sigmask(SIG_BLOCK, &blocked, &previous);
+
+  string cmd = "exec " + command + (cnfFile != "" ? " '" + cnfFile + "'" : "");
+  pid = fork();
+  if (pid == 0) {
+    // the handlers killing the solvers are not for the solver itself
+    for (int sig : {SIGINT, SIGTERM}) {
+      struct sigaction current;
+      if (sigaction(sig, nullptr, &current) == 0 && current.sa_handler == killSolverGroups) {
+        signal(sig, SIG_DFL);
+      }
+    }
+    pthread_sigmask(SIG_SETMASK, &previous, nullptr);
+    setpgid(0, 0);
+    dup2(inPipe[0], STDIN_FILENO);
+    dup2(outPipe[1], STDOUT_FILENO);
+    execl("/bin/sh", "sh", "-c", cmd.c_str(), (char*)nullptr);
+    _exit(127);
+  }
+  if (pid > 0) {
+    // the group is also set here, so that it exists before the child gets to it
+    setpgid(pid, pid);
+    registerSolverGroup(pid);
+  }
+  pthread_sigmask(SIG_SETMASK, &previous, nullptr);
+  close(inPipe[0]);
+  close(outPipe[1]);
+  if (pid < 0) {
+    close(inPipe[1]);
+    close(outPipe[0]);
+    ERROR("cannot run the solver '" + command + "'");
+  }
+  out = outPipe[0];
+  if (cnfFile != "") {
+    close(inPipe[1]);
+  } else {
+    in = fdopen(inPipe[1], "w");
+    CHECK(in != nullptr, "cannot open the input of the solver");
+  }
+
+  reader = thread([this]() {
+    char chunk[1 << 16];
+    ssize_t len;
+    while ((len = read(out, chunk, sizeof(chunk))) != 0) {
+      if (len < 0) {
+        if (errno == EINTR) continue;
+        break;
+      }
+      output.append(chunk, size_t(len));
+    }
+  });
+
+  // the waiter blocks until the solver exits; the solver is reaped by the owner, so that
+  // its group stays registered until then
+  pid_t child = pid;
+  waiter = thread([this, child]() {
+    siginfo_t info;
+    while (waitid(P_PID, id_t(child), &info, WEXITED | WNOWAIT) != 0 && errno == EINTR) {
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    exited = true;
+    exitSignal.notify_all();
+  });
+}
+
+SolverProcess::~SolverProcess() {
+  if (pid > 0) {
+    kill(-pid, SIGKILL);
+    reap();
+  }
+  stop();
+}
+
+// closes the pipes and joins the reader and the waiter
+void SolverProcess::stop() {
+  if (in != nullptr) {
+    fclose(in);
+    in = nullptr;
+  }
+  if (reader.joinable()) {
+    reader.join();
+  }
+  if (waiter.joinable()) {
+    waiter.join();
+  }
+  if (out >= 0) {
+    close(out);
+    out = -1;
+  }
+}
+
+// waits until the solver exits; returns false after the timeout
+bool SolverProcess::waitExit(std::chrono::milliseconds timeout) {
+  std::unique_lock<std::mutex> lock(mutex);
+  return exitSignal.wait_for(lock, timeout, [&]() {
+    return exited;
+  });
+}
+
+// reaps the solver, which is no longer killed on a signal afterwards; returns its status
+int SolverProcess::reap() {
+  unregisterSolverGroup(pid);
+  int status = 0;
+  while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {
+  }
+  pid = -1;
+  return status;
+}
+
+void SolverProcess::inputFailed() {
+  // the solver is given a second to exit
+  string reason;
+  if (waitExit(std::chrono::seconds(1))) {
+    int status = reap();
+    CHECK(!WIFEXITED(status) || WEXITSTATUS(status) != 127, "cannot run the solver '" + command + "'");
+    reason = WIFEXITED(status) ? " (exit code " + to_string(WEXITSTATUS(status)) + ")" : " (killed)";
+  }
+  ERROR("the solver '" + command + "' stopped reading the model" + reason);
+}
+
+bool SolverProcess::wait(SatAssignment& result, function<bool()> terminate) {
+  if (in != nullptr) {
+    fclose(in);
+    in = nullptr;
+  }
+
+  // terminate() is checked every 10 milliseconds while blocking on the exit; killed solvers
+  // get a second to exit after SIGTERM
+  bool killed = false;
+  if (!terminate) {
+    std::unique_lock<std::mutex> lock(mutex);
+    exitSignal.wait(lock, [&]() {
+      return exited;
+    });
+  } else {
+    int graceTicks = 0;
+    while (!waitExit(std::chrono::milliseconds(10))) {
+      if (!killed && terminate()) {
+        kill(-pid, SIGTERM);
+        killed = true;
+      } else if (killed && ++graceTicks == 100) {
+        kill(-pid, SIGKILL);
+      }
+    }
+  }
+  // children of the solver may keep the output open
+  if (killed) {
+    kill(-pid, SIGKILL);
+  }
+  int status = reap();
+  stop();
+  if (killed) {
+    return false;
+  }
+
+  // solvers exit with 10 (SAT) or 20 (UNSAT), so only a failed start is an error
+  CHECK(!WIFEXITED(status) || WEXITSTATUS(status) != 127, "cannot run the solver '" + command + "'");
+  parseAssignment(output.data(), output.size(), "the output of '" + command + "'", result);
+  return true;
+}
@@ -0,0 +1,272 @@
+#pragma once
+
+#include "logging.h"
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <functional>
+#include <cstdio>
+#include <sys/types.h>
+#include <zlib.h>
+
+// A consumer of the clauses produced by the encoders
+class ClauseSink {
+ public:
+  virtual ~ClauseSink() {}
+
+  // lits are in the dimacs convention: +(id + 1) or -(id + 1)
+  virtual void addClause(const int* lits, size_t size) = 0;
+
+  // called once after the last clause
+  virtual void finish(int varCount, size_t clauseCount) {}
+};
+
+// Counts clauses and literals without storing them
+class CountingSink : public ClauseSink {
+ public:
+  size_t clauses = 0;
+  size_t literals = 0;
+
+  void addClause(const int* lits, size_t size) override {
+    clauses++;
+    literals += size;
+  }
+};
+
+// Compresses a sequence of blocks into a single deflate stream. Every block is compressed
+// independently (and possibly in parallel by worker threads); non-final blocks end with a
+// sync flush, so their concatenation is a valid deflate stream
+class ParallelDeflater {
+  ParallelDeflater(const ParallelDeflater&);
+  ParallelDeflater& operator = (const ParallelDeflater&);
+
+  struct Block {
+    std::vector<char> input;
+    size_t inputSize = 0;
+    std::vector<unsigned char> output;
+    uLong crc = 0;
+    bool last = false;
+    bool done = false;
+  };
+
+ public:
+  // compressed blocks are passed to write(data, size) in order
+  ParallelDeflater(int level, int threads, std::function<void(const unsigned char*, size_t)> write);
+  ~ParallelDeflater();
+
+  // compresses the first size bytes of the input; the input is swapped with a free buffer
+  void add(std::vector<char>& input, size_t size, bool last);
+  // waits for all the blocks to be written
+  void finish();
+
+  // checksum and length of the uncompressed data
+  uLong crc() const {
+    return totalCrc;
+  }
+  size_t size() const {
+    return totalSize;
+  }
+
+ private:
+  int level;
+  std::function<void(const unsigned char*, size_t)> write;
+  uLong totalCrc;
+  size_t totalSize = 0;
+
+  std::vector<std::thread> workers;
+  std::mutex mutex;
+  std::condition_variable workAvailable;
+  std::condition_variable blockDone;
+  // all blocks not yet written, in the stream order
+  std::deque<std::shared_ptr<Block>> blocks;
+  // blocks waiting for a worker
+  std::deque<std::shared_ptr<Block>> pending;
+  std::vector<std::vector<char>> freeBuffers;
+  bool stopping = false;
+
+  void compress(Block& block) const;
+  void workerLoop();
+  void writeCompleted(size_t maxInFlight);
+};
+
+// Output formats of CNF files:
+//  - TEXT: the usual dimacs format
+//  - BINARY: a compact format ('.bcnf'):
+//      "BCNF", version byte, 3 zero bytes,
+//      var count and clause count as 64-bit little-endian integers,
+//      for every clause: varint(size) followed by its literals sorted by variable, each
+//      stored as varint((var - previous var) * 2 + negative) with previous var starting at 0
+enum CnfFormat { TEXT_CNF, BINARY_CNF };
+
+// Chooses the format by the file extension ('.bcnf' or '.bcnf.gz' for binary)
+CnfFormat cnfFormat(const std::string& filename);
+
+// Writes clauses to a file in the given format, gzip-compressed if the name ends with '.gz'.
+// If the header is not written before the first clause, space for it is reserved at the
+// beginning of the file and patched in finish()
+class CnfWriter : public ClauseSink {
+  CnfWriter(const CnfWriter&);
+  CnfWriter& operator = (const CnfWriter&);
+
+ public:
+  CnfWriter(const std::string& filename, int compressionLevel = 9, int threads = 1);
+  // writes text dimacs to an open stream (e.g. a pipe), which finish() flushes but does
+  // not close; the header has to be written first
+  CnfWriter(FILE* stream, const std::string& name);
+  ~CnfWriter();
+
+  void writeHeader(int varCount, size_t clauseCount);
+  void addClause(const int* lits, size_t size) override;
+  void finish(int varCount, size_t clauseCount) override;
+
+ private:
+  // the size of the reserved text header (enough for any 'p cnf' line)
+  static const size_t TEXT_HEADER_SIZE = 64;
+  static const size_t BUFFER_SIZE = 1 << 20;
+
+  std::string filename;
+  CnfFormat format;
+  FILE* file = nullptr;
+  bool compressed = false;
+  bool headerWritten = false;
+  bool reservedHeader = false;
+  bool finished = false;
+  // writing to an open stream, which cannot be patched and is not closed by finish()
+  bool isStream = false;
+  size_t headerSize = 0;
+
+  std::vector<char> buffer;
+  size_t bufferSize = 0;
+  std::vector<int> sortedLits;
+
+  // compressor for the gzip output
+  std::unique_ptr<ParallelDeflater> deflater;
+
+  std::string header(int varCount, size_t clauseCount, bool reserved) const;
+  void startFile(const std::string& content, bool reserved);
+  void flush(bool last);
+  void writeRaw(const void* data, size_t size);
+  void writeGzipHeader(const std::string& content);
+};
+
+// Reads a CNF file in any of the supported formats (plain or gzip-compressed) and passes
+// its clauses to the sink; returns the variable count from the header
+int readCnf(const std::string& filename, ClauseSink& sink);
+
+// Variable assignment of a solver run: the status from the 's' line and the values from
+// the 'v' lines, stored as dense bit vectors indexed by variable id
+class SatAssignment {
+ public:
+  std::string status;
+  // the number of distinct variables with a value
+  size_t assignedCount = 0;
+
+  void resize(size_t varCount) {
+    size_t words = (varCount + 63) / 64;
+    values.assign(words, 0);
+    assigned.assign(words, 0);
+    numVars = varCount;
+    assignedCount = 0;
+    status = "";
+  }
+
+  size_t size() const {
+    return numVars;
+  }
+
+  // records the value of a variable given by a dimacs literal; returns false if the
+  // literal is out of range or the variable already has a value
+  bool assign(int lit) {
+    size_t id = size_t(lit > 0 ? lit : -lit) - 1;
+    if (id >= numVars) return false;
+    uint64_t bit = uint64_t(1) << (id & 63);
+    if (assigned[id >> 6] & bit) return false;
+    assigned[id >> 6] |= bit;
+    if (lit > 0) values[id >> 6] |= bit;
+    assignedCount++;
+    return true;
+  }
+
+  bool isAssigned(int id) const {
+    return size_t(id) < numVars && ((assigned[id >> 6] >> (id & 63)) & 1) != 0;
+  }
+
+  bool value(int id) const {
+    return ((values[id >> 6] >> (id & 63)) & 1) != 0;
+  }
+
+  // overrides the value of an assigned variable
+  void set(int id, bool value) {
+    uint64_t bit = uint64_t(1) << (id & 63);
+    if (value) {
+      values[id >> 6] |= bit;
+    } else {
+      values[id >> 6] &= ~bit;
+    }
+  }
+
+ private:
+  size_t numVars = 0;
+  std::vector<uint64_t> values;
+  std::vector<uint64_t> assigned;
+};
+
+// Parses a solver output file (memory-mapped) into the assignment, which has to be
+// resized to the expected number of variables beforehand
+void readAssignment(const std::string& filename, SatAssignment& result);
+
+// Parses solver output in the competition format ('s' and 'v' lines); the source names
+// the output in error messages
+void parseAssignment(const char* data, size_t size, const std::string& source, SatAssignment& result);
+
+// An external solver running as '<command>' (reading the CNF from stdin) or as
+// '<command> <cnf>'. Its stdout is collected in memory by a reader thread. The solver
+// runs in its own process group, so that it can be killed together with its children
+class SolverProcess {
+  SolverProcess(const SolverProcess&);
+  SolverProcess& operator = (const SolverProcess&);
+
+ public:
+  explicit SolverProcess(const std::string& command, const std::string& cnfFile = "");
+  ~SolverProcess();
+
+  // the stdin of the solver (only without a CNF file); closing it ends the input
+  FILE* input() {
+    return in;
+  }
+
+  // waits for the solver and parses its output into the assignment, which has to be
+  // resized beforehand. The solver is killed (SIGTERM, then SIGKILL) as soon as
+  // terminate() is true, in which case false is returned
+  bool wait(SatAssignment& result, std::function<bool()> terminate);
+
+  // reports a failed write to the input: the solver did not start or stopped reading
+  void inputFailed();
+
+ private:
+  std::string command;
+  pid_t pid = -1;
+  FILE* in = nullptr;
+  int out = -1;
+  std::string output;
+  std::thread reader;
+  std::thread waiter;
+  // set by the waiter once the solver exited (not yet reaped)
+  std::mutex mutex;
+  std::condition_variable exitSignal;
+  bool exited = false;
+
+  bool waitExit(std::chrono::milliseconds timeout);
+  int reap();
+  void stop();
+};
+
+// Kills the process groups of the running solvers on SIGINT and SIGTERM before bob
+// terminates, which otherwise leaves them running
+void killSolversOnSignals();
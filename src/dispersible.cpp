@@ -1,3 +1,4 @@
+#include "cardinality.h"
 #include "logging.h"
 #include "glucoseMain.h"
 #include "sat_model.h"
@@ -49,37 +50,18 @@ void encodeDispersible(SATModel& model, InputGraph& inputGraph, Params& params)
         continue;
       }
 
-      model.addClause(MClause(model.getSamePageVar(i, j, false)));
+      if (!inputGraph.fixedPages.empty()) {
+        // adjacent edges on the same fixed page: an empty clause
+        if (inputGraph.fixedPages[i] == inputGraph.fixedPages[j]) {
+          model.addClause(MClause());
+        }
+        continue;
+      }
+      model.addClause({model.getSamePageVar(i, j, false)});
     }
   }
 }
 
-void genSubsetsRec(int n, int k, int index, int cnt, vector<int>& cur, vector<vector<int>>& res) {
-  if (cnt == k) {
-    res.push_back(cur);
-    return;
-  }
-
-  if (index >= n) {
-    return;
-  }
-
-  // current is included, put next at next location
-  cur[cnt] = index;
-  genSubsetsRec(n, k, index + 1, cnt + 1, cur, res);
-  // current is excluded
-  genSubsetsRec(n, k, index + 1, cnt, cur, res);
-}
-
-// gen all subsets of n elements of size k
-vector<vector<int>> genSubsets(int n, int k) {
-  vector<vector<int>> res;
-  auto cur = vector<int>(k, -1);
-  genSubsetsRec(n, k, 0, 0, cur, res);
-  //LOG("generated %d subsets for n = %d and k = %d", res.size(), n, k);
-  return res;
-}
-
 void encodeLocal(SATModel& model, InputGraph& inputGraph, Params& params) {
   auto& edges = inputGraph.edges;
   int n = inputGraph.nc;
@@ -106,7 +88,6 @@ void encodeLocal(SATModel& model, InputGraph& inputGraph, Params& params) {
       continue;
     }
 
-    CHECK(na <= 40, "large-degree graphs are not supported");
     // variable: v is adjacent to page X
     vector<int> vAdjVar;
 
@@ -116,46 +97,19 @@ void encodeLocal(SATModel& model, InputGraph& inputGraph, Params& params) {
       MClause clause = MClause(MVar(var, false));
 
       for (int edgeIdx : adjEdges) {
-        model.addClause(MClause(model.getPageVar(edgeIdx, p, false), MVar(var, true)));
+        model.addClause({model.getPageVar(edgeIdx, p, false), MVar(var, true)});
         clause.addVar(model.getPageVar(edgeIdx, p, true));
       }
 
       model.addClause(clause);
     }
 
-    // check subsets of size local+1
-    auto subsets = genSubsets(pages, local + 1);
-
-    for (auto& subset : subsets) {
-      CHECK((int)subset.size() == local + 1);
-      MClause clause;
-
-      for (int p : subset) {
-        clause.addVar(MVar(vAdjVar[p], false));
-      }
-
-      model.addClause(clause);
-    }
-
-    // among every subset of edges of size (local+1), two are on the same page
-    auto subsets2 = genSubsets(na, local + 1);
-
-    for (auto& subset : subsets2) {
-      CHECK((int)subset.size() == local + 1);
-      MClause clause;
-
-      for (int e1 : subset) {
-        for (int e2 : subset) {
-          if (e1 >= e2) {
-            continue;
-          }
-
-          clause.addVar(model.getSamePageVar(adjEdges[e1], adjEdges[e2], true));
-        }
-      }
-
-      model.addClause(clause);
+    // at most local pages are adjacent to v
+    vector<MVar> adjPages;
+    for (int var : vAdjVar) {
+      adjPages.push_back(MVar(var, true));
     }
+    addAtMostK(model, adjPages, local, params.localCardinality);
   }
 
   if (m == n * (n - 1) / 2) {
@@ -170,7 +124,7 @@ void encodeLocal(SATModel& model, InputGraph& inputGraph, Params& params) {
     for (int i = 1; i < n; i++) {
       for (int p = local; p < pages; p++) {
         int edgeIdx = inputGraph.findEdgeIndex(0, i);
-        model.addClause(MClause(model.getPageVar(edgeIdx, p, false)));
+        model.addClause({model.getPageVar(edgeIdx, p, false)});
       }
     }
   }
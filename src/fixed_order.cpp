@@ -0,0 +1,332 @@
+#include "fixed_order.h"
+#include "logging.h"
+
+#include <algorithm>
+#include <climits>
+#include <fstream>
+#include <set>
+
+using namespace std;
+
+namespace {
+
+// The pairs of crossing (nesting) edges for the positions of the vertices. The sweep visits
+// the positions from left to right, keeping the edges that span the position ordered by
+// their right end; an edge (c, d) starting at c is crossed by the active edges ending in
+// (c, d) and nested by the ones ending after d
+vector<pair<int, int>> orderConflicts(const InputGraph& inputGraph, const vector<int>& pos, bool nestings) {
+  int n = inputGraph.nc;
+  vector<vector<int>> starting(n);
+  vector<vector<int>> ending(n);
+  vector<int> right(inputGraph.edges.size());
+  for (size_t e = 0; e < inputGraph.edges.size(); e++) {
+    int a = pos[inputGraph.edges[e].first];
+    int b = pos[inputGraph.edges[e].second];
+    starting[min(a, b)].push_back(int(e));
+    ending[max(a, b)].push_back(int(e));
+    right[e] = max(a, b);
+  }
+
+  vector<pair<int, int>> conflicts;
+  set<pair<int, int>> active;
+  for (int c = 0; c < n; c++) {
+    for (int e : ending[c]) {
+      active.erase(make_pair(c, e));
+    }
+    for (int f : starting[c]) {
+      int d = right[f];
+      if (nestings) {
+        for (auto it = active.upper_bound(make_pair(d, INT_MAX)); it != active.end(); ++it) {
+          conflicts.push_back(make_pair(it->second, f));
+        }
+      } else {
+        for (auto it = active.begin(); it != active.end() && it->first < d; ++it) {
+          conflicts.push_back(make_pair(it->second, f));
+        }
+      }
+    }
+    // edges with a common left end neither cross nor nest
+    for (int f : starting[c]) {
+      active.insert(make_pair(right[f], f));
+    }
+  }
+  return conflicts;
+}
+
+// the pairs of edges with a common vertex
+vector<pair<int, int>> adjacentEdges(const InputGraph& inputGraph) {
+  vector<vector<int>> incident(inputGraph.nc);
+  for (size_t e = 0; e < inputGraph.edges.size(); e++) {
+    incident[inputGraph.edges[e].first].push_back(int(e));
+    incident[inputGraph.edges[e].second].push_back(int(e));
+  }
+  vector<pair<int, int>> res;
+  for (auto& edges : incident) {
+    for (size_t i = 0; i < edges.size(); i++) {
+      for (size_t j = i + 1; j < edges.size(); j++) {
+        res.push_back(make_pair(edges[i], edges[j]));
+      }
+    }
+  }
+  return res;
+}
+
+// 2-colours the conflict graph by a BFS (1-colours it if it has no edges)
+bool colourTwoPages(size_t m, const vector<pair<int, int>>& conflicts, int pageCount, vector<int>& pages) {
+  if (pageCount == 1) {
+    pages.assign(m, 0);
+    return conflicts.empty();
+  }
+  vector<vector<int>> adj(m);
+  for (auto& pr : conflicts) {
+    adj[pr.first].push_back(pr.second);
+    adj[pr.second].push_back(pr.first);
+  }
+  pages.assign(m, -1);
+  vector<int> queue;
+  for (size_t root = 0; root < m; root++) {
+    if (pages[root] != -1) continue;
+    pages[root] = 0;
+    queue.assign(1, int(root));
+    for (size_t i = 0; i < queue.size(); i++) {
+      int e = queue[i];
+      for (int f : adj[e]) {
+        if (pages[f] == -1) {
+          pages[f] = 1 - pages[e];
+          queue.push_back(f);
+        } else if (pages[f] == pages[e]) {
+          return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+// the nesting depth of every edge: an edge is one page above the deepest edge nesting it.
+// Nesting is a partial order, so the depth + 1 is the longest chain of nested edges, which
+// is also the least number of queues
+bool layerQueues(const InputGraph& inputGraph, const vector<int>& pos, const vector<pair<int, int>>& nestings, int pageCount, vector<int>& pages) {
+  size_t m = inputGraph.edges.size();
+  vector<vector<int>> outer(m);
+  for (auto& pr : nestings) {
+    outer[pr.second].push_back(pr.first);
+  }
+  // the outer edges come first: by the left end, then by the right end descending
+  vector<int> edges(m);
+  vector<pair<int, int>> span(m);
+  for (size_t e = 0; e < m; e++) {
+    edges[e] = int(e);
+    int a = pos[inputGraph.edges[e].first];
+    int b = pos[inputGraph.edges[e].second];
+    span[e] = make_pair(min(a, b), -max(a, b));
+  }
+  sort(edges.begin(), edges.end(), [&](int e, int f) {
+    return span[e] < span[f];
+  });
+
+  pages.assign(m, 0);
+  for (int e : edges) {
+    for (int f : outer[e]) {
+      pages[e] = max(pages[e], pages[f] + 1);
+    }
+    if (pages[e] >= pageCount) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// the edges conflicting with every edge on a stack page, on a queue page and on all pages
+struct Conflicts {
+  explicit Conflicts(size_t m): stack(m), queue(m), all(m) {}
+
+  vector<vector<int>> stack;
+  vector<vector<int>> queue;
+  vector<vector<int>> all;
+
+  static void add(vector<vector<int>>& adj, const vector<pair<int, int>>& pairs) {
+    for (auto& pr : pairs) {
+      adj[pr.first].push_back(pr.second);
+      adj[pr.second].push_back(pr.first);
+    }
+  }
+};
+
+// first-fit colouring with the edges ordered by the left end, the longer first; the edges
+// that fit on no page keep -1. Returns the number of such edges
+size_t firstFitPages(const InputGraph& inputGraph, const Params& params, const vector<int>& pos, const Conflicts& conflicts, vector<int>& pages) {
+  size_t m = inputGraph.edges.size();
+  vector<int> edges(m);
+  vector<pair<int, int>> span(m);
+  for (size_t e = 0; e < m; e++) {
+    edges[e] = int(e);
+    int a = pos[inputGraph.edges[e].first];
+    int b = pos[inputGraph.edges[e].second];
+    span[e] = make_pair(min(a, b), -max(a, b));
+  }
+  sort(edges.begin(), edges.end(), [&](int e, int f) {
+    return span[e] < span[f];
+  });
+
+  int pageCount = params.stacks + params.queues;
+  pages.assign(m, -1);
+  size_t unplaced = 0;
+  vector<bool> blocked(pageCount);
+  for (int e : edges) {
+    blocked.assign(pageCount, false);
+    for (int f : conflicts.all[e]) {
+      if (pages[f] != -1) blocked[pages[f]] = true;
+    }
+    for (int f : conflicts.stack[e]) {
+      if (pages[f] != -1 && pages[f] < params.stacks) blocked[pages[f]] = true;
+    }
+    for (int f : conflicts.queue[e]) {
+      if (pages[f] >= params.stacks) blocked[pages[f]] = true;
+    }
+    auto it = find(blocked.begin(), blocked.end(), false);
+    if (it == blocked.end()) {
+      unplaced++;
+    } else {
+      pages[e] = int(it - blocked.begin());
+    }
+  }
+  return unplaced;
+}
+
+// a colouring model with a variable per edge and page, starting from the first-fit pages;
+// the pages of a stack-only or queue-only layout are interchangeable, so the first edge is
+// fixed to page 0
+SatSolver::Result colourPages(const InputGraph& inputGraph, const Params& params, const vector<pair<int, int>>& crossings,
+                              const vector<pair<int, int>>& nestings, const vector<pair<int, int>>& adjacent,
+                              const function<bool()>& terminate, vector<int>& pages) {
+  int m = int(inputGraph.edges.size());
+  int pageCount = params.stacks + params.queues;
+  auto var = [&](int e, int p) {
+    return e * pageCount + p + 1;
+  };
+
+  auto solver = createSolver(params.solver, params.seed);
+  solver->setTerminate(terminate);
+  size_t clauseCount = 0;
+  for (int e = 0; e < m; e++) {
+    for (int p = 0; p < pageCount; p++) {
+      solver->add(var(e, p));
+    }
+    solver->add(0);
+    clauseCount++;
+  }
+  auto addConflicts = [&](const vector<pair<int, int>>& pairs, int from, int to) {
+    for (auto& pr : pairs) {
+      for (int p = from; p < to; p++) {
+        solver->add(-var(pr.first, p));
+        solver->add(-var(pr.second, p));
+        solver->add(0);
+        clauseCount++;
+      }
+    }
+  };
+  addConflicts(crossings, 0, params.stacks);
+  addConflicts(nestings, params.stacks, pageCount);
+  addConflicts(adjacent, 0, pageCount);
+  if (params.breakSymmetry && !params.isMixed()) {
+    solver->add(var(0, 0));
+    solver->add(0);
+    clauseCount++;
+  }
+  solver->finish(m * pageCount, clauseCount);
+  for (int e = 0; e < m; e++) {
+    if (pages[e] == -1) continue;
+    for (int p = 0; p < pageCount; p++) {
+      solver->phase(p == pages[e] ? var(e, p) : -var(e, p));
+    }
+  }
+
+  auto res = solver->solve();
+  if (res == SatSolver::SAT) {
+    pages.assign(m, -1);
+    for (int e = 0; e < m; e++) {
+      for (int p = 0; p < pageCount && pages[e] == -1; p++) {
+        if (solver->val(var(e, p)) > 0) {
+          pages[e] = p;
+        }
+      }
+    }
+  }
+  return res;
+}
+
+}
+
+vector<int> readOrder(const string& file, const InputGraph& inputGraph) {
+  ifstream in(file);
+  CHECK(in.good(), "cannot open order file '" + file + "'");
+  vector<int> order;
+  vector<bool> seen(inputGraph.nc, false);
+  string label;
+  while (in >> label) {
+    auto it = inputGraph.label2id.find(label);
+    CHECK(it != inputGraph.label2id.end(), "vertex " + label + " of the order is not in the graph");
+    CHECK(!seen[it->second], "vertex " + label + " is repeated in the order");
+    seen[it->second] = true;
+    order.push_back(it->second);
+  }
+  CHECK(int(order.size()) == inputGraph.nc, "the order has " + to_string(order.size()) + " of " + to_string(inputGraph.nc) + " vertices");
+  return order;
+}
+
+SatSolver::Result assignPagesForOrder(const InputGraph& inputGraph, const Params& params, const function<bool()>& terminate, Layout& layout) {
+  CHECK(params.isStack() || params.isQueue() || params.isMixed(), "a fixed order is supported for stack, queue and mixed layouts");
+  CHECK(!params.trees && !params.adjacent && !params.strict && params.local == 0 && inputGraph.numCustomConstraints() == 0 &&
+        inputGraph.planar_edges.empty() && inputGraph.planar_faces.empty(), "a fixed order cannot be combined with other constraints");
+  CHECK(int(layout.order.size()) == inputGraph.nc);
+
+  vector<int> pos(inputGraph.nc);
+  for (int i = 0; i < inputGraph.nc; i++) {
+    pos[layout.order[i]] = i;
+  }
+  if (params.directed) {
+    for (auto& edge : inputGraph.directedEdges()) {
+      if (pos[edge.first] > pos[edge.second]) {
+        LOG_IF(params.verbose, "the order is against the direction of edge (%s, %s)", inputGraph.id2label.find(edge.first)->second.c_str(),
+               inputGraph.id2label.find(edge.second)->second.c_str());
+        return SatSolver::UNSAT;
+      }
+    }
+  }
+
+  vector<pair<int, int>> crossings;
+  vector<pair<int, int>> nestings;
+  vector<pair<int, int>> adjacent;
+  if (params.stacks > 0) {
+    crossings = orderConflicts(inputGraph, pos, false);
+  }
+  if (params.queues > 0) {
+    nestings = orderConflicts(inputGraph, pos, true);
+  }
+  if (params.dispersible) {
+    adjacent = adjacentEdges(inputGraph);
+  }
+  LOG_IF(params.verbose, "fixed order with %zu crossings, %zu nestings and %zu adjacent pairs", crossings.size(), nestings.size(), adjacent.size());
+
+  int pageCount = params.stacks + params.queues;
+  if (params.isQueue() && !params.dispersible) {
+    return layerQueues(inputGraph, pos, nestings, pageCount, layout.pages) ? SatSolver::SAT : SatSolver::UNSAT;
+  }
+  if (!params.isMixed() && pageCount <= 2) {
+    auto pairs = params.isStack() ? crossings : nestings;
+    pairs.insert(pairs.end(), adjacent.begin(), adjacent.end());
+    return colourTwoPages(inputGraph.edges.size(), pairs, pageCount, layout.pages) ? SatSolver::SAT : SatSolver::UNSAT;
+  }
+
+  Conflicts conflicts(inputGraph.edges.size());
+  Conflicts::add(conflicts.stack, crossings);
+  Conflicts::add(conflicts.queue, nestings);
+  Conflicts::add(conflicts.all, adjacent);
+  size_t unplaced = firstFitPages(inputGraph, params, pos, conflicts, layout.pages);
+  LOG_IF(params.verbose, "first-fit pages place %zu of %zu edges", inputGraph.edges.size() - unplaced, inputGraph.edges.size());
+  if (unplaced == 0) {
+    return SatSolver::SAT;
+  }
+  return colourPages(inputGraph, params, crossings, nestings, adjacent, terminate, layout.pages);
+}
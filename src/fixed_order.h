@@ -0,0 +1,19 @@
+#pragma once
+
+#include "glucoseMain.h"
+#include "sat_solver.h"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+// Reads a vertex order: the labels of all vertices, each once, separated by whitespace
+std::vector<int> readOrder(const std::string& file, const InputGraph& inputGraph);
+
+// Assigns the edges to the pages for the vertex order of the layout, without the relative
+// order variables. Two edges conflict on a stack (queue) page if they cross (nest), which a
+// sweep line over the order finds in O(m log m + K) for K conflicts; edges with a common
+// vertex conflict on all pages of dispersible layouts. The conflict graph is 2-coloured for
+// two pages of one type, queues are layered by the nesting depth (which is optimal), and the
+// rest is coloured first-fit, or else by a SAT model with a variable per edge and page
+SatSolver::Result assignPagesForOrder(const InputGraph& inputGraph, const Params& params, const std::function<bool()>& terminate, Layout& layout);
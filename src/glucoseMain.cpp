@@ -1,7 +1,16 @@
+#include "automorphisms.h"
+#include "cardinality.h"
+#include "cnf_preprocessor.h"
 #include "common.h"
+#include "cubes.h"
+#include "decomposition.h"
+#include "fixed_order.h"
+#include "heuristic.h"
+#include "kernel.h"
 #include "glucoseMain.h"
 #include "logging.h"
 #include "sat_model.h"
+#include "sat_solver.h"
 
 #include <iostream>
 #include <fstream>
@@ -10,40 +19,120 @@
 #include <set>
 #include <queue>
 #include <map>
+#include <memory>
+#include <tuple>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 
 using namespace std;
 
-void encodeRelative(SATModel& model, InputGraph& inputGraph) {
+// fixes the relative order of the pairs in the transitive closure of nodeRel;
+// a cyclic nodeRel results in an empty clause
+void fixRelativeOrder(SATModel& model, InputGraph& inputGraph) {
   int n = inputGraph.nc;
+  vector<vector<int>> succ(n);
+  for (auto& rel : inputGraph.nodeRel) {
+    CHECK(0 <= rel.first && rel.first < n && 0 <= rel.second && rel.second < n && rel.first != rel.second,
+          "incorrect nodeRel (" + to_string(rel.first) + ", " + to_string(rel.second) + ")");
+    succ[rel.first].push_back(rel.second);
+  }
 
-  //create variables
+  vector<int> visited(n, -1);
+  vector<int> stack;
   for (int i = 0; i < n; i++) {
-    for (int j = 0; j < n; j++) {
-      model.addRelVar(i, j);
+    stack.assign(succ[i].begin(), succ[i].end());
+    while (!stack.empty()) {
+      int v = stack.back();
+      stack.pop_back();
+      if (visited[v] == i || v == i) continue;
+      visited[v] = i;
+      model.fixVar(model.getRelVar(i, v, true));
+      stack.insert(stack.end(), succ[v].begin(), succ[v].end());
     }
   }
+}
+
+// transitivity of the relative order on vertices i < j < k
+void addTransitivityClauses(SATModel& model, int i, int j, int k) {
+  model.addClause({model.getRelVar(i, j, false), model.getRelVar(j, k, false), model.getRelVar(i, k, true)});
+  model.addClause({model.getRelVar(i, j, true), model.getRelVar(j, k, true), model.getRelVar(i, k, false)});
+}
+
+void encodeRelative(SATModel& model, InputGraph& inputGraph, const Params& params) {
+  int n = inputGraph.nc;
+
+  //create variables
+  model.addRelVars(n);
+  fixRelativeOrder(model, inputGraph);
+
+  // added for the cyclic triples of the solutions only
+  if (params.lazyTransitivity) {
+    return;
+  }
 
   //ensure transitivity
   for (int i = 0; i < n; i++) {
     for (int j = i + 1; j < n; j++) {
       for (int k = j + 1; k < n; k++) {
-        model.addClause(MClause(model.getRelVar(i, j, false), model.getRelVar(j, k, false), model.getRelVar(i, k, true)));
-        model.addClause(MClause(model.getRelVar(i, j, true), model.getRelVar(j, k, true), model.getRelVar(i, k, false)));
+        addTransitivityClauses(model, i, j, k);
+      }
+    }
+  }
+}
+
+// fixes the page variables of the edges with restricted pages
+void fixPages(SATModel& model, InputGraph& inputGraph, int pageCount) {
+  for (auto& pr : inputGraph.edgePages) {
+    int index = pr.first;
+    auto& pages = pr.second;
+    CHECK(0 <= index && index < (int)inputGraph.edges.size(), "incorrect edgePages");
+
+    vector<bool> allowed(pageCount, false);
+    for (int page : pages) {
+      CHECK(0 <= page && page < pageCount, "incorrect edgePages");
+      allowed[page] = true;
+    }
+    for (int page = 0; page < pageCount; page++) {
+      if (!allowed[page]) {
+        model.fixVar(model.getPageVar(index, page, false));
       }
     }
+    if (pages.size() == 1) {
+      model.fixVar(model.getPageVar(index, pages[0], true));
+    }
   }
 }
 
-void encodePageVariables(SATModel& model, InputGraph& inputGraph, int pageCount) {
+// whether same-page variables are linked to the page variables with O(p) clauses
+// per pair instead of O(p^2)
+bool linearSamePages(const Params& params, int pageCount) {
+  return params.samePageEncoding == SP_LINEAR || (params.samePageEncoding == SP_AUTO && pageCount >= 3);
+}
+
+void encodePageVariables(SATModel& model, InputGraph& inputGraph, const Params& params, int pageCount) {
   int m = inputGraph.edges.size();
 
-  // create variables
-  for (int i = 0; i < m; i++) {
-    for (int j = 0; j < pageCount; j++) {
-      model.addPageVar(i, j);
+  // a fixed page assignment needs neither page variables nor same-page variables: the
+  // pairs on distinct pages are unconstrained
+  if (!inputGraph.fixedPages.empty()) {
+    CHECK(params.isStack() || params.isQueue() || params.isMixed(), "fixed pages are supported for stack, queue and mixed layouts");
+    CHECK(int(inputGraph.fixedPages.size()) == m, "incorrect fixed pages");
+    for (int page : inputGraph.fixedPages) {
+      CHECK(0 <= page && page < pageCount, "incorrect fixed page " + to_string(page));
     }
+    CHECK(inputGraph.edgePages.empty() && inputGraph.samePage.empty() && inputGraph.distinctPage.empty() && inputGraph.groupEdgePages.empty(),
+          "fixed pages cannot be combined with page constraints");
+    CHECK(find(inputGraph.multiPage.begin(), inputGraph.multiPage.end(), true) == inputGraph.multiPage.end(), "fixed pages cannot be combined with multi-page edges");
+    return;
   }
 
+  // create variables
+  model.addPageVars(m, pageCount);
+  fixPages(model, inputGraph, pageCount);
+
   // at least one page
   for (int i = 0; i < m; i++) {
     MClause clause;
@@ -61,82 +150,82 @@ void encodePageVariables(SATModel& model, InputGraph& inputGraph, int pageCount)
       continue;
     }
 
+    vector<MVar> pages;
     for (int j = 0; j < pageCount; j++) {
-      for (int k = j + 1; k < pageCount; k++) {
-        model.addClause(MClause(model.getPageVar(i, j, false), model.getPageVar(i, k, false)));
-      }
+      pages.push_back(model.getPageVar(i, j, true));
     }
+    addAtMostOne(model, pages, params.pageCardinality);
   }
 
   CHECK(inputGraph.multiPage.size() == inputGraph.edges.size() || inputGraph.multiPage.empty());
 
-  // set same-page variables
-  for (int i = 0; i < m; i++) {
-    for (int j = i + 1; j < m; j++) {
-      // add var
-      model.addSamePageVar(i, j);
-      //set on same page var
+  // same-page variables, created only for the pairs referenced by the constraints
+  auto isMulti = [&inputGraph](int edge) {
+    return inputGraph.multiPage.size() == inputGraph.edges.size() && inputGraph.multiPage[edge];
+  };
+  bool linear = linearSamePages(params, pageCount);
+  model.addSamePageVars(m, [&model, isMulti, pageCount, linear](int i, int j, const MVar& sp) {
+    bool multi = isMulti(i) || isMulti(j);
+    // the quadratic encoding requires single-page edges
+    if (!linear && !multi) {
+      // both on the same page => sp; on distinct pages => !sp
       for (int j1 = 0; j1 < pageCount; j1++) {
         for (int j2 = 0; j2 < pageCount; j2++) {
-          model.addClause( MClause(model.getPageVar(i, j1, false), model.getPageVar(j, j2, false), model.getSamePageVar(i, j, (j1 == j2))) );
+          model.addClause({model.getPageVar(i, j1, false), model.getPageVar(j, j2, false), MVar(sp.id(), j1 == j2)});
         }
       }
-    }
-  }
-
-/*  // set same-page variables
-  for (int i = 0; i < m; i++) {
-    for (int j = i + 1; j < m; j++) {
-      // add var
-      model.addSamePageVar(i, j);
-      // add vars onSamePageK
-      vector<int> pageKVar;
-      for (int page = 0; page < pageCount; page++) {
-        int var = model.addVar();
-        pageKVar.push_back(var);
-        // both on page K     => i on page K and j on page K
-        model.addClause(MClause(MVar(var, false), model.getPageVar(i, page, true)));
-        model.addClause(MClause(MVar(var, false), model.getPageVar(j, page, true)));
-        // at most one page K => either i not page K or j not on page K
-        model.addClause(MClause(MVar(var, true), model.getPageVar(i, page, false), model.getPageVar(j, page, false)));
-      }
-
-      // set on same page var
-      // - samePage=true  => at least one common page
-      MClause clause(model.getSamePageVar(i, j, false));
+    } else {
+      // a common page => sp
       for (int page = 0; page < pageCount; page++) {
-        clause.addVar(MVar(pageKVar[page], true));
+        model.addClause({model.getPageVar(i, page, false), model.getPageVar(j, page, false), MVar(sp.id(), true)});
       }
-      model.addClause(clause);
 
-      // - samePage=false => no common pages
-      for (int page = 0; page < pageCount; page++) {
-        model.addClause(MClause(model.getSamePageVar(i, j, true), model.getPageVar(i, page, false), model.getPageVar(j, page, false)));
+      // sp => a common page
+      if (!isMulti(i) || !isMulti(j)) {
+        // the page of a single-page edge is also a page of the other one
+        int single = isMulti(i) ? j : i;
+        int other = single == i ? j : i;
+        for (int page = 0; page < pageCount; page++) {
+          model.addClause({MVar(sp.id(), false), model.getPageVar(single, page, false), model.getPageVar(other, page, true)});
+        }
+      } else {
+        // both edges on page K => i on page K and j on page K
+        MClause clause(MVar(sp.id(), false));
+        for (int page = 0; page < pageCount; page++) {
+          MVar both(model.addVar(), true);
+          model.addClause({MVar(both.id(), false), model.getPageVar(i, page, true)});
+          model.addClause({MVar(both.id(), false), model.getPageVar(j, page, true)});
+          clause.addVar(both);
+        }
+        model.addClause(clause);
       }
-
-      // // old (incorrect)
-      // bool multiI = inputGraph.multiPage.size() == inputGraph.edges.size() && inputGraph.multiPage[i];
-      // bool multiJ = inputGraph.multiPage.size() == inputGraph.edges.size() && inputGraph.multiPage[j];
-      // for (int p1 = 0; p1 < pageCount; p1++) {
-      //   for (int p2 = 0; p2 < pageCount; p2++) {
-      //     if (p1 != p2 && (multiI || multiJ)) {
-      //       continue;
-      //     }
-
-      //     model.addClause(MClause(model.getPageVar(i, p1, false), model.getPageVar(j, p2, false), model.getSamePageVar(i, j, (p1 == p2))));
-      //   }
-      // }
     }
-  }*/
+  });
+
+  for (auto& pr : inputGraph.samePage) {
+    model.fixVar(model.getSamePageVar(pr.first, pr.second, true));
+  }
+  for (auto& pr : inputGraph.distinctPage) {
+    model.fixVar(model.getSamePageVar(pr.first, pr.second, false));
+  }
 }
 
-void encodeTrackVariables(SATModel& model, InputGraph& inputGraph, int trackCount) {
+void encodeTrackVariables(SATModel& model, InputGraph& inputGraph, const Params& params, int trackCount) {
   int n = inputGraph.nc;
 
   // create variables
-  for (int i = 0; i < n; i++) {
-    for (int j = 0; j < trackCount; j++) {
-      model.addTrackVar(i, j);
+  model.addTrackVars(n, trackCount);
+  for (auto& pr : inputGraph.nodeTracks) {
+    CHECK(0 <= pr.first && pr.first < n);
+    vector<bool> allowed(trackCount, false);
+    for (int track : pr.second) {
+      CHECK(0 <= track && track < trackCount);
+      allowed[track] = true;
+    }
+    for (int track = 0; track < trackCount; track++) {
+      if (!allowed[track]) {
+        model.fixVar(model.getTrackVar(pr.first, track, false));
+      }
     }
   }
 
@@ -153,24 +242,20 @@ void encodeTrackVariables(SATModel& model, InputGraph& inputGraph, int trackCoun
 
   // at most one track per vertex
   for (int i = 0; i < n; i++) {
-    MClause clause;
-
+    vector<MVar> tracks;
     for (int j = 0; j < trackCount; j++) {
-      for (int k = j + 1; k < trackCount; k++) {
-        model.addClause(MClause(model.getTrackVar(i, j, false), model.getTrackVar(i, k, false)));
-      }
+      tracks.push_back(model.getTrackVar(i, j, true));
     }
+    addAtMostOne(model, tracks, params.trackCardinality);
   }
 
   // same track variables
+  model.addSameTrackVars(n);
   for (int i = 0; i < n; i++) {
     for (int j = i + 1; j < n; j++) {
-      // add var
-      model.addSameTrackVar(i, j);
-
       //set on same track var
       for (int k = 0; k < trackCount; k++) {
-        model.addClause(MClause(model.getTrackVar(i, k, false), model.getTrackVar(j, k, false), model.getSameTrackVar(i, j, true)));
+        model.addClause({model.getTrackVar(i, k, false), model.getTrackVar(j, k, false), model.getSameTrackVar(i, j, true)});
       }
     }
   }
@@ -182,34 +267,103 @@ void encodeTrackVariables(SATModel& model, InputGraph& inputGraph, int trackCoun
         for (int u = 0; u < n; u++) {
           if (v == u) continue;
           // u on track_i && v on track_j => u < v
-          model.addClause( MClause(model.getTrackVar(u, i, false), model.getTrackVar(v, j, false), model.getRelVar(u, v, true)) );
+          model.addClause({model.getTrackVar(u, i, false), model.getTrackVar(v, j, false), model.getRelVar(u, v, true)});
         }
       }
     }
   }*/
 }
 
-MClause crossingClause(SATModel& model, int edge1, int edge2, int a, int b, int c, int d) {
-  // returns a clause forbidding pattern a < b < c < d
-  return MClause(model.getSamePageVar(edge1, edge2, false), model.getRelVar(a, b, true), model.getRelVar(b, c, true), model.getRelVar(c, d, true));
+// whether the pattern forbidden by a crossing clause (d < c < b < a) is not already
+// excluded by the fixed relative order, that is, the clause is not satisfied
+template <typename Model>
+bool patternPossible(Model& model, int a, int b, int c, int d) {
+  return model.knownValue(model.getRelVar(a, b, true)) <= 0 &&
+         model.knownValue(model.getRelVar(b, c, true)) <= 0 &&
+         model.knownValue(model.getRelVar(c, d, true)) <= 0;
+}
+
+template <typename Model>
+void addCrossingClause(Model& model, int edge1, int edge2, int a, int b, int c, int d) {
+  // adds a clause forbidding pattern a < b < c < d
+  if (!patternPossible(model, a, b, c, d)) return;
+  model.addClause({model.getSamePageVar(edge1, edge2, false), model.getRelVar(a, b, true), model.getRelVar(b, c, true), model.getRelVar(c, d, true)});
+}
+
+template <typename Model>
+void addCrossingClause(Model& model, int a, int b, int c, int d) {
+  // adds a clause forbidding pattern a < b < c < d for two edges on the same fixed page
+  if (!patternPossible(model, a, b, c, d)) return;
+  model.addClause({model.getRelVar(a, b, true), model.getRelVar(b, c, true), model.getRelVar(c, d, true)});
+}
+
+template <typename Model>
+void addCrossingClause(Model& model, int edge1, int edge2, int a, int b, int c, int d, int page) {
+  // adds a clause forbidding pattern a < b < c < d when both edges are on the page
+  if (!patternPossible(model, a, b, c, d)) return;
+  model.addClause({model.getSamePageVar(edge1, edge2, false), model.getRelVar(a, b, true), model.getRelVar(b, c, true), model.getRelVar(c, d, true),
+                   model.getPageVar(edge1, page, false), model.getPageVar(edge2, page, false)});
+}
+
+template <typename Model>
+void addCrossingClause(Model& model, int edge1, int edge2, int a, int b, int c, int d, int page, const MVar& pageType) {
+  // adds a clause forbidding pattern a < b < c < d when both edges are on the page of the given type
+  if (!patternPossible(model, a, b, c, d)) return;
+  model.addClause({model.getSamePageVar(edge1, edge2, false), model.getRelVar(a, b, true), model.getRelVar(b, c, true), model.getRelVar(c, d, true),
+                   model.getPageVar(edge1, page, false), model.getPageVar(edge2, page, false), pageType});
+}
+
+// a variable implied by every possible pattern a < b < c < d of the list, defined once
+// per edge pair and shared by the clauses of all pages; -1 if no pattern is possible
+template <typename Model>
+int addPatternVar(Model& model, const int patterns[][4], int count) {
+  int var = -1;
+  for (int k = 0; k < count; k++) {
+    int a = patterns[k][0], b = patterns[k][1], c = patterns[k][2], d = patterns[k][3];
+    if (!patternPossible(model, a, b, c, d)) continue;
+    if (var < 0) {
+      var = model.addVar();
+    }
+    model.addClause({model.getRelVar(a, b, true), model.getRelVar(b, c, true), model.getRelVar(c, d, true), MVar(var, true)});
+  }
+  return var;
+}
+
+// the "crosses" and "nests" variables of a pair of independent edges
+template <typename Model>
+pair<int, int> addPatternVars(Model& model, int e1n1, int e1n2, int e2n1, int e2n2, bool crossings, bool nestings) {
+  const int crossing[8][4] = {
+    {e1n1, e2n1, e1n2, e2n2}, {e1n1, e2n2, e1n2, e2n1}, {e1n2, e2n1, e1n1, e2n2}, {e1n2, e2n2, e1n1, e2n1},
+    {e2n1, e1n1, e2n2, e1n2}, {e2n1, e1n2, e2n2, e1n1}, {e2n2, e1n1, e2n1, e1n2}, {e2n2, e1n2, e2n1, e1n1},
+  };
+  const int nesting[8][4] = {
+    {e1n1, e2n1, e2n2, e1n2}, {e1n1, e2n2, e2n1, e1n2}, {e1n2, e2n1, e2n2, e1n1}, {e1n2, e2n2, e2n1, e1n1},
+    {e2n1, e1n1, e1n2, e2n2}, {e2n1, e1n2, e1n1, e2n2}, {e2n2, e1n1, e1n2, e2n1}, {e2n2, e1n2, e1n1, e2n1},
+  };
+  int crosses = crossings ? addPatternVar(model, crossing, 8) : -1;
+  int nests = nestings ? addPatternVar(model, nesting, 8) : -1;
+  return make_pair(crosses, nests);
 }
 
-MClause strictClause(SATModel& model, int edge1, int edge2, int u, int v1, int v2, bool left) {
+template <typename Model>
+void addStrictClause(Model& model, int edge1, int edge2, int u, int v1, int v2, bool left) {
   // forbids u < v1,v2 on the same page [with left = true]
   // forbids v1,2 < u on the same page [with left = false]
   if (left) {
-    return MClause(model.getSamePageVar(edge1, edge2, false), model.getRelVar(u, v1, false), model.getRelVar(u, v2, false));
+    model.addClause({model.getSamePageVar(edge1, edge2, false), model.getRelVar(u, v1, false), model.getRelVar(u, v2, false)});
   } else {
-    return MClause(model.getSamePageVar(edge1, edge2, false), model.getRelVar(v1, u, false), model.getRelVar(v2, u, false));
+    model.addClause({model.getSamePageVar(edge1, edge2, false), model.getRelVar(v1, u, false), model.getRelVar(v2, u, false)});
   }
 }
 
-MClause XClause(SATModel& model, int edge1, int edge2, int x, int y, int u, int v) {
-  // returns a clause forbidding an X-cross
-  return MClause(model.getSamePageVar(edge1, edge2, false), model.getSameTrackVar(x, v, false), model.getSameTrackVar(y, u, false), model.getRelVar(x, v, true), model.getRelVar(u, y, true));
+template <typename Model>
+void addXClause(Model& model, int edge1, int edge2, int x, int y, int u, int v) {
+  // adds a clause forbidding an X-cross
+  model.addClause({model.getSamePageVar(edge1, edge2, false), model.getSameTrackVar(x, v, false), model.getSameTrackVar(y, u, false), model.getRelVar(x, v, true), model.getRelVar(u, y, true)});
 }
 
-void encodeStackEdge(SATModel& model, InputGraph& inputGraph, int index, Params params) {
+template <typename Model>
+void encodeStackEdge(Model& model, InputGraph& inputGraph, int index, const Params& params) {
   int e1n1 = inputGraph.edges[index].first;
   int e1n2 = inputGraph.edges[index].second;
   CHECK(e1n1 < e1n2);
@@ -225,18 +379,19 @@ void encodeStackEdge(SATModel& model, InputGraph& inputGraph, int index, Params
     }
 
     // forbid crossings between i-th and index-th
-    model.addClause(crossingClause(model, i, index, e1n1, e2n1, e1n2, e2n2));
-    model.addClause(crossingClause(model, i, index, e1n1, e2n2, e1n2, e2n1));
-    model.addClause(crossingClause(model, i, index, e1n2, e2n1, e1n1, e2n2));
-    model.addClause(crossingClause(model, i, index, e1n2, e2n2, e1n1, e2n1));
-    model.addClause(crossingClause(model, i, index, e2n1, e1n1, e2n2, e1n2));
-    model.addClause(crossingClause(model, i, index, e2n1, e1n2, e2n2, e1n1));
-    model.addClause(crossingClause(model, i, index, e2n2, e1n1, e2n1, e1n2));
-    model.addClause(crossingClause(model, i, index, e2n2, e1n2, e2n1, e1n1));
+    addCrossingClause(model, i, index, e1n1, e2n1, e1n2, e2n2);
+    addCrossingClause(model, i, index, e1n1, e2n2, e1n2, e2n1);
+    addCrossingClause(model, i, index, e1n2, e2n1, e1n1, e2n2);
+    addCrossingClause(model, i, index, e1n2, e2n2, e1n1, e2n1);
+    addCrossingClause(model, i, index, e2n1, e1n1, e2n2, e1n2);
+    addCrossingClause(model, i, index, e2n1, e1n2, e2n2, e1n1);
+    addCrossingClause(model, i, index, e2n2, e1n1, e2n1, e1n2);
+    addCrossingClause(model, i, index, e2n2, e1n2, e2n1, e1n1);
   }
 }
 
-void encodeQueueEdge(SATModel& model, InputGraph& inputGraph, int index, Params params) {
+template <typename Model>
+void encodeQueueEdge(Model& model, InputGraph& inputGraph, int index, const Params& params) {
   int u1 = inputGraph.edges[index].first;
   int v1 = inputGraph.edges[index].second;
   CHECK(u1 < v1);
@@ -251,50 +406,51 @@ void encodeQueueEdge(SATModel& model, InputGraph& inputGraph, int index, Params
       if (params.strict) {
         if (u1 == u2) {
           CHECK(v1 != v2);
-          model.addClause(strictClause(model, index, i, u1, v1, v2, true));
-          model.addClause(strictClause(model, index, i, u1, v1, v2, false));
+          addStrictClause(model, index, i, u1, v1, v2, true);
+          addStrictClause(model, index, i, u1, v1, v2, false);
         }
         if (u1 == v2) {
           CHECK(v1 != u2);
-          model.addClause(strictClause(model, index, i, u1, v1, u2, true));
-          model.addClause(strictClause(model, index, i, u1, v1, u2, false));
+          addStrictClause(model, index, i, u1, v1, u2, true);
+          addStrictClause(model, index, i, u1, v1, u2, false);
         }
         if (v1 == u2) {
           CHECK(u1 != v2);
-          model.addClause(strictClause(model, index, i, v1, u1, v2, true));
-          model.addClause(strictClause(model, index, i, v1, u1, v2, false));
+          addStrictClause(model, index, i, v1, u1, v2, true);
+          addStrictClause(model, index, i, v1, u1, v2, false);
         }
         if (v1 == v2) {
           CHECK(u1 != u2);
-          model.addClause(strictClause(model, index, i, v1, u1, u2, true));
-          model.addClause(strictClause(model, index, i, v1, u1, u2, false));
+          addStrictClause(model, index, i, v1, u1, u2, true);
+          addStrictClause(model, index, i, v1, u1, u2, false);
         }
       }
       continue;
     }
 
     // forbid nestings between i-th and index-th
-    model.addClause(crossingClause(model, i, index, u1, u2, v2, v1));
-    model.addClause(crossingClause(model, i, index, u1, v2, u2, v1));
-    model.addClause(crossingClause(model, i, index, v1, u2, v2, u1));
-    model.addClause(crossingClause(model, i, index, v1, v2, u2, u1));
-    model.addClause(crossingClause(model, i, index, u2, u1, v1, v2));
-    model.addClause(crossingClause(model, i, index, u2, v1, u1, v2));
-    model.addClause(crossingClause(model, i, index, v2, u1, v1, u2));
-    model.addClause(crossingClause(model, i, index, v2, v1, u1, u2));
+    addCrossingClause(model, i, index, u1, u2, v2, v1);
+    addCrossingClause(model, i, index, u1, v2, u2, v1);
+    addCrossingClause(model, i, index, v1, u2, v2, u1);
+    addCrossingClause(model, i, index, v1, v2, u2, u1);
+    addCrossingClause(model, i, index, u2, u1, v1, v2);
+    addCrossingClause(model, i, index, u2, v1, u1, v2);
+    addCrossingClause(model, i, index, v2, u1, v1, u2);
+    addCrossingClause(model, i, index, v2, v1, u1, u2);
   }
 }
 
-void encodeTrackEdge(SATModel& model, InputGraph& inputGraph, int index, Params params) {
+template <typename Model>
+void encodeTrackEdge(Model& model, InputGraph& inputGraph, int index, const Params& params) {
   int e1n1 = inputGraph.edges[index].first;
   int e1n2 = inputGraph.edges[index].second;
   CHECK(e1n1 < e1n2);
   // every edge spans two tracks
-  model.addClause(MClause(model.getSameTrackVar(e1n1, e1n2, false)));
+  model.addClause({model.getSameTrackVar(e1n1, e1n2, false)});
 
   // one page => fix
   if (params.stacks + params.queues == 1) {
-    model.addClause(MClause(model.getPageVar(index, 0, true)));
+    model.addClause({model.getPageVar(index, 0, true)});
   }
 
   for (int i = 0; i < index; i++) {
@@ -308,23 +464,31 @@ void encodeTrackEdge(SATModel& model, InputGraph& inputGraph, int index, Params
     }
 
     // forbid x-crosses
-    model.addClause(XClause(model, i, index, e1n1, e1n2, e2n1, e2n2));
-    model.addClause(XClause(model, i, index, e1n1, e1n2, e2n2, e2n1));
-    model.addClause(XClause(model, i, index, e1n2, e1n1, e2n1, e2n2));
-    model.addClause(XClause(model, i, index, e1n2, e1n1, e2n2, e2n1));
-    model.addClause(XClause(model, i, index, e2n1, e2n2, e1n1, e1n2));
-    model.addClause(XClause(model, i, index, e2n1, e2n2, e1n2, e1n1));
-    model.addClause(XClause(model, i, index, e2n2, e2n1, e1n1, e1n2));
-    model.addClause(XClause(model, i, index, e2n2, e2n1, e1n2, e1n1));
+    addXClause(model, i, index, e1n1, e1n2, e2n1, e2n2);
+    addXClause(model, i, index, e1n1, e1n2, e2n2, e2n1);
+    addXClause(model, i, index, e1n2, e1n1, e2n1, e2n2);
+    addXClause(model, i, index, e1n2, e1n1, e2n2, e2n1);
+    addXClause(model, i, index, e2n1, e2n2, e1n1, e1n2);
+    addXClause(model, i, index, e2n1, e2n2, e1n2, e1n1);
+    addXClause(model, i, index, e2n2, e2n1, e1n1, e1n2);
+    addXClause(model, i, index, e2n2, e2n1, e1n2, e1n1);
   }
 }
 
-void encodeMixedEdge(SATModel& model, InputGraph& inputGraph, int index, Params params) {
+// Edge pairs of a fixed page assignment: only the pairs on the same page are constrained,
+// against crossings on a stack page and against nestings on a queue page
+template <typename Model>
+void encodeFixedPageEdge(Model& model, InputGraph& inputGraph, int index, const Params& params) {
+  CHECK(!params.strict, "fixed pages are not supported for strict queue layouts");
   int e1n1 = inputGraph.edges[index].first;
   int e1n2 = inputGraph.edges[index].second;
   CHECK(e1n1 < e1n2);
+  int page = inputGraph.fixedPages[index];
 
   for (int i = 0; i < index; i++) {
+    if (inputGraph.fixedPages[i] != page) {
+      continue;
+    }
     int e2n1 = inputGraph.edges[i].first;
     int e2n2 = inputGraph.edges[i].second;
     CHECK(e2n1 < e2n2);
@@ -334,33 +498,93 @@ void encodeMixedEdge(SATModel& model, InputGraph& inputGraph, int index, Params
       continue;
     }
 
+    if (page < params.stacks) {
+      addCrossingClause(model, e1n1, e2n1, e1n2, e2n2);
+      addCrossingClause(model, e1n1, e2n2, e1n2, e2n1);
+      addCrossingClause(model, e1n2, e2n1, e1n1, e2n2);
+      addCrossingClause(model, e1n2, e2n2, e1n1, e2n1);
+      addCrossingClause(model, e2n1, e1n1, e2n2, e1n2);
+      addCrossingClause(model, e2n1, e1n2, e2n2, e1n1);
+      addCrossingClause(model, e2n2, e1n1, e2n1, e1n2);
+      addCrossingClause(model, e2n2, e1n2, e2n1, e1n1);
+    } else {
+      addCrossingClause(model, e1n1, e2n1, e2n2, e1n2);
+      addCrossingClause(model, e1n1, e2n2, e2n1, e1n2);
+      addCrossingClause(model, e1n2, e2n1, e2n2, e1n1);
+      addCrossingClause(model, e1n2, e2n2, e2n1, e1n1);
+      addCrossingClause(model, e2n1, e1n1, e1n2, e2n2);
+      addCrossingClause(model, e2n1, e1n2, e1n1, e2n2);
+      addCrossingClause(model, e2n2, e1n1, e1n2, e2n1);
+      addCrossingClause(model, e2n2, e1n2, e1n1, e2n1);
+    }
+  }
+}
+
+// whether mixed and mixed-page layouts use the shared "crosses" and "nests" variables:
+// 16 defining clauses per edge pair and a short clause per page instead of 8 long
+// clauses per page
+bool sharedPatterns(const Params& params) {
+  if (params.patternEncoding != PATTERN_AUTO) {
+    return params.patternEncoding == PATTERN_SHARED;
+  }
+  return params.isMixedPages() ? params.mixedPages >= 2 : params.stacks + params.queues >= 3;
+}
+
+template <typename Model>
+void encodeMixedEdge(Model& model, InputGraph& inputGraph, int index, const Params& params) {
+  int e1n1 = inputGraph.edges[index].first;
+  int e1n2 = inputGraph.edges[index].second;
+  CHECK(e1n1 < e1n2);
+
+  for (int i = 0; i < index; i++) {
+    int e2n1 = inputGraph.edges[i].first;
+    int e2n2 = inputGraph.edges[i].second;
+    CHECK(e2n1 < e2n2);
+
+    // no constraints for adjacent edges
+    if (e1n1 == e2n1 || e1n1 == e2n2 || e1n2 == e2n1 || e1n2 == e2n2) {
+      continue;
+    }
+
+    if (sharedPatterns(params)) {
+      // the pair crosses (nests) => not on the same stack (queue) page
+      auto vars = addPatternVars(model, e1n1, e1n2, e2n1, e2n2, true, true);
+      for (int page = 0; page < params.stacks + params.queues; page++) {
+        int var = page < params.stacks ? vars.first : vars.second;
+        if (var < 0) continue;
+        model.addClause({MVar(var, false), model.getPageVar(i, page, false), model.getPageVar(index, page, false)});
+      }
+      continue;
+    }
+
     // forbid crossings between i-th and index-th edges on pages [0, params.stacks)
     for (int page = 0; page < params.stacks; page++) {
-      model.addClause(MClause(crossingClause(model, i, index, e1n1, e2n1, e1n2, e2n2), model.getPageVar(i, page, false), model.getPageVar(index, page, false)));
-      model.addClause(MClause(crossingClause(model, i, index, e1n1, e2n2, e1n2, e2n1), model.getPageVar(i, page, false), model.getPageVar(index, page, false)));
-      model.addClause(MClause(crossingClause(model, i, index, e1n2, e2n1, e1n1, e2n2), model.getPageVar(i, page, false), model.getPageVar(index, page, false)));
-      model.addClause(MClause(crossingClause(model, i, index, e1n2, e2n2, e1n1, e2n1), model.getPageVar(i, page, false), model.getPageVar(index, page, false)));
-      model.addClause(MClause(crossingClause(model, i, index, e2n1, e1n1, e2n2, e1n2), model.getPageVar(i, page, false), model.getPageVar(index, page, false)));
-      model.addClause(MClause(crossingClause(model, i, index, e2n1, e1n2, e2n2, e1n1), model.getPageVar(i, page, false), model.getPageVar(index, page, false)));
-      model.addClause(MClause(crossingClause(model, i, index, e2n2, e1n1, e2n1, e1n2), model.getPageVar(i, page, false), model.getPageVar(index, page, false)));
-      model.addClause(MClause(crossingClause(model, i, index, e2n2, e1n2, e2n1, e1n1), model.getPageVar(i, page, false), model.getPageVar(index, page, false)));
+      addCrossingClause(model, i, index, e1n1, e2n1, e1n2, e2n2, page);
+      addCrossingClause(model, i, index, e1n1, e2n2, e1n2, e2n1, page);
+      addCrossingClause(model, i, index, e1n2, e2n1, e1n1, e2n2, page);
+      addCrossingClause(model, i, index, e1n2, e2n2, e1n1, e2n1, page);
+      addCrossingClause(model, i, index, e2n1, e1n1, e2n2, e1n2, page);
+      addCrossingClause(model, i, index, e2n1, e1n2, e2n2, e1n1, page);
+      addCrossingClause(model, i, index, e2n2, e1n1, e2n1, e1n2, page);
+      addCrossingClause(model, i, index, e2n2, e1n2, e2n1, e1n1, page);
     }
 
     // forbid nestings between i-th and index-th edges on pages [params.stacks, params.stacks + params.queues)
     for (int page = params.stacks; page < params.stacks + params.queues; page++) {
-      model.addClause(MClause(crossingClause(model, i, index, e1n1, e2n1, e2n2, e1n2), model.getPageVar(i, page, false), model.getPageVar(index, page, false)));
-      model.addClause(MClause(crossingClause(model, i, index, e1n1, e2n2, e2n1, e1n2), model.getPageVar(i, page, false), model.getPageVar(index, page, false)));
-      model.addClause(MClause(crossingClause(model, i, index, e1n2, e2n1, e2n2, e1n1), model.getPageVar(i, page, false), model.getPageVar(index, page, false)));
-      model.addClause(MClause(crossingClause(model, i, index, e1n2, e2n2, e2n1, e1n1), model.getPageVar(i, page, false), model.getPageVar(index, page, false)));
-      model.addClause(MClause(crossingClause(model, i, index, e2n1, e1n1, e1n2, e2n2), model.getPageVar(i, page, false), model.getPageVar(index, page, false)));
-      model.addClause(MClause(crossingClause(model, i, index, e2n1, e1n2, e1n1, e2n2), model.getPageVar(i, page, false), model.getPageVar(index, page, false)));
-      model.addClause(MClause(crossingClause(model, i, index, e2n2, e1n1, e1n2, e2n1), model.getPageVar(i, page, false), model.getPageVar(index, page, false)));
-      model.addClause(MClause(crossingClause(model, i, index, e2n2, e1n2, e1n1, e2n1), model.getPageVar(i, page, false), model.getPageVar(index, page, false)));
+      addCrossingClause(model, i, index, e1n1, e2n1, e2n2, e1n2, page);
+      addCrossingClause(model, i, index, e1n1, e2n2, e2n1, e1n2, page);
+      addCrossingClause(model, i, index, e1n2, e2n1, e2n2, e1n1, page);
+      addCrossingClause(model, i, index, e1n2, e2n2, e2n1, e1n1, page);
+      addCrossingClause(model, i, index, e2n1, e1n1, e1n2, e2n2, page);
+      addCrossingClause(model, i, index, e2n1, e1n2, e1n1, e2n2, page);
+      addCrossingClause(model, i, index, e2n2, e1n1, e1n2, e2n1, page);
+      addCrossingClause(model, i, index, e2n2, e1n2, e1n1, e2n1, page);
     }
   }
 }
 
-void encodeMixedPageEdge(SATModel& model, InputGraph& inputGraph, int index, Params params) {
+template <typename Model>
+void encodeMixedPageEdge(Model& model, InputGraph& inputGraph, int index, const Params& params) {
   int e1n1 = inputGraph.edges[index].first;
   int e1n2 = inputGraph.edges[index].second;
   CHECK(e1n1 < e1n2);
@@ -375,83 +599,164 @@ void encodeMixedPageEdge(SATModel& model, InputGraph& inputGraph, int index, Par
       continue;
     }
 
+    if (sharedPatterns(params)) {
+      // the pair crosses (nests) => not on the same page if it is a stack (queue)
+      auto vars = addPatternVars(model, e1n1, e1n2, e2n1, e2n2, true, true);
+      for (int page = 0; page < params.mixedPages; page++) {
+        if (vars.first >= 0) {
+          model.addClause({MVar(vars.first, false), model.getPageVar(i, page, false), model.getPageVar(index, page, false),
+                           model.getPageTypeVar(page, false)});
+        }
+        if (vars.second >= 0) {
+          model.addClause({MVar(vars.second, false), model.getPageVar(i, page, false), model.getPageVar(index, page, false),
+                           model.getPageTypeVar(page, true)});
+        }
+      }
+      continue;
+    }
+
     for (int page = 0; page < params.mixedPages; page++) {      
       // forbid crossings between i-th and index-th edges, if the page is a stack
-      model.addClause(MClause(
-        crossingClause(model, i, index, e1n1, e2n1, e1n2, e2n2), 
-        model.getPageVar(i, page, false), 
-        model.getPageVar(index, page, false), 
-        model.getPageTypeVar(page, false)
-      ));
-      model.addClause(MClause(
-        crossingClause(model, i, index, e1n1, e2n2, e1n2, e2n1), 
-        model.getPageVar(i, page, false), 
-        model.getPageVar(index, page, false),
-        model.getPageTypeVar(page, false)
-      ));
-      model.addClause(MClause(
-        crossingClause(model, i, index, e1n2, e2n1, e1n1, e2n2), 
-        model.getPageVar(i, page, false), 
-        model.getPageVar(index, page, false),
-        model.getPageTypeVar(page, false)
-      ));
-      model.addClause(MClause(
-        crossingClause(model, i, index, e1n2, e2n2, e1n1, e2n1), 
-        model.getPageVar(i, page, false), 
-        model.getPageVar(index, page, false),
-        model.getPageTypeVar(page, false)
-      ));
-      model.addClause(MClause(
-        crossingClause(model, i, index, e2n1, e1n1, e2n2, e1n2), 
-        model.getPageVar(i, page, false), 
-        model.getPageVar(index, page, false),
-        model.getPageTypeVar(page, false)
-      ));
-      model.addClause(MClause(
-        crossingClause(model, i, index, e2n1, e1n2, e2n2, e1n1), 
-        model.getPageVar(i, page, false), 
-        model.getPageVar(index, page, false),
-        model.getPageTypeVar(page, false)
-      ));
-      model.addClause(MClause(
-        crossingClause(model, i, index, e2n2, e1n1, e2n1, e1n2), 
-        model.getPageVar(i, page, false), 
-        model.getPageVar(index, page, false),
-        model.getPageTypeVar(page, false)
-      ));
-      model.addClause(MClause(
-        crossingClause(model, i, index, e2n2, e1n2, e2n1, e1n1), 
-        model.getPageVar(i, page, false), 
-        model.getPageVar(index, page, false),
-        model.getPageTypeVar(page, false)
-      ));
+      addCrossingClause(model, i, index, e1n1, e2n1, e1n2, e2n2, page, model.getPageTypeVar(page, false));
+      addCrossingClause(model, i, index, e1n1, e2n2, e1n2, e2n1, page, model.getPageTypeVar(page, false));
+      addCrossingClause(model, i, index, e1n2, e2n1, e1n1, e2n2, page, model.getPageTypeVar(page, false));
+      addCrossingClause(model, i, index, e1n2, e2n2, e1n1, e2n1, page, model.getPageTypeVar(page, false));
+      addCrossingClause(model, i, index, e2n1, e1n1, e2n2, e1n2, page, model.getPageTypeVar(page, false));
+      addCrossingClause(model, i, index, e2n1, e1n2, e2n2, e1n1, page, model.getPageTypeVar(page, false));
+      addCrossingClause(model, i, index, e2n2, e1n1, e2n1, e1n2, page, model.getPageTypeVar(page, false));
+      addCrossingClause(model, i, index, e2n2, e1n2, e2n1, e1n1, page, model.getPageTypeVar(page, false));
 
       // forbid nestings between i-th and index-th edges on pages, if the page is a queue
-      model.addClause(MClause(crossingClause(model, i, index, e1n1, e2n1, e2n2, e1n2), model.getPageVar(i, page, false), model.getPageVar(index, page, false), model.getPageTypeVar(page, true)));
-      model.addClause(MClause(crossingClause(model, i, index, e1n1, e2n2, e2n1, e1n2), model.getPageVar(i, page, false), model.getPageVar(index, page, false), model.getPageTypeVar(page, true)));
-      model.addClause(MClause(crossingClause(model, i, index, e1n2, e2n1, e2n2, e1n1), model.getPageVar(i, page, false), model.getPageVar(index, page, false), model.getPageTypeVar(page, true)));
-      model.addClause(MClause(crossingClause(model, i, index, e1n2, e2n2, e2n1, e1n1), model.getPageVar(i, page, false), model.getPageVar(index, page, false), model.getPageTypeVar(page, true)));
-      model.addClause(MClause(crossingClause(model, i, index, e2n1, e1n1, e1n2, e2n2), model.getPageVar(i, page, false), model.getPageVar(index, page, false), model.getPageTypeVar(page, true)));
-      model.addClause(MClause(crossingClause(model, i, index, e2n1, e1n2, e1n1, e2n2), model.getPageVar(i, page, false), model.getPageVar(index, page, false), model.getPageTypeVar(page, true)));
-      model.addClause(MClause(crossingClause(model, i, index, e2n2, e1n1, e1n2, e2n1), model.getPageVar(i, page, false), model.getPageVar(index, page, false), model.getPageTypeVar(page, true)));
-      model.addClause(MClause(crossingClause(model, i, index, e2n2, e1n2, e1n1, e2n1), model.getPageVar(i, page, false), model.getPageVar(index, page, false), model.getPageTypeVar(page, true)));
+      addCrossingClause(model, i, index, e1n1, e2n1, e2n2, e1n2, page, model.getPageTypeVar(page, true));
+      addCrossingClause(model, i, index, e1n1, e2n2, e2n1, e1n2, page, model.getPageTypeVar(page, true));
+      addCrossingClause(model, i, index, e1n2, e2n1, e2n2, e1n1, page, model.getPageTypeVar(page, true));
+      addCrossingClause(model, i, index, e1n2, e2n2, e2n1, e1n1, page, model.getPageTypeVar(page, true));
+      addCrossingClause(model, i, index, e2n1, e1n1, e1n2, e2n2, page, model.getPageTypeVar(page, true));
+      addCrossingClause(model, i, index, e2n1, e1n2, e1n1, e2n2, page, model.getPageTypeVar(page, true));
+      addCrossingClause(model, i, index, e2n2, e1n1, e1n2, e2n1, page, model.getPageTypeVar(page, true));
+      addCrossingClause(model, i, index, e2n2, e1n2, e1n1, e2n1, page, model.getPageTypeVar(page, true));
     }
   }
 }
 
-void encodeAdjacent(SATModel& model, InputGraph& inputGraph, int pageCount) {
-  int n = inputGraph.nc;
+// the number of edge pairs encoded into a buffer by a worker
+const size_t EDGE_PAIRS_PER_BLOCK = 1 << 16;
+
+// encodes the pairwise constraints of every edge with its predecessors. With several
+// threads, blocks of consecutive edges are encoded in parallel into clause buffers, which
+// are added to the model in the order of the edges, so the model is the same as the one
+// of a single-threaded run. Encoding stops between blocks once terminate() is true, leaving
+// the model incomplete
+void encodeEdges(SATModel& model, InputGraph& inputGraph, const Params& params, const std::function<bool()>& terminate,
+                 void (*encodeEdge)(SATModel&, InputGraph&, int, const Params&),
+                 void (*bufferEdge)(EdgeClauseBuffer&, InputGraph&, int, const Params&)) {
+  int m = int(inputGraph.edges.size());
+  if (params.threads <= 1 || size_t(m) * (m - 1) / 2 < 2 * EDGE_PAIRS_PER_BLOCK) {
+    size_t pairs = 0;
+    for (int i = 0; i < m; i++) {
+      pairs += i;
+      if (pairs >= EDGE_PAIRS_PER_BLOCK) {
+        if (terminate && terminate()) return;
+        pairs = 0;
+      }
+      encodeEdge(model, inputGraph, i, params);
+    }
+    return;
+  }
 
-  //create variables
-  for (int i = 0; i < n; i++) {
-    for (int j = 0; j < n; j++) {
-      if (i == j) {
-        continue;
+  // edge index has index pairs, so later blocks have fewer edges
+  vector<int> starts(1, 0);
+  size_t pairs = 0;
+  for (int i = 0; i < m; i++) {
+    pairs += i;
+    if (pairs >= EDGE_PAIRS_PER_BLOCK) {
+      starts.push_back(i + 1);
+      pairs = 0;
+    }
+  }
+  if (starts.back() != m) {
+    starts.push_back(m);
+  }
+  size_t blockCount = starts.size() - 1;
+
+  // placeholders of same-page variables do not collide with the variables of the model
+  int firstPlaceholder = int(model.varCount());
+  vector<unique_ptr<EdgeClauseBuffer>> buffers(blockCount);
+  vector<bool> done(blockCount, false);
+  std::atomic<size_t> nextBlock(0);
+  std::atomic<bool> failed(false);
+  std::atomic<bool> stopped(false);
+  std::mutex mutex;
+  std::condition_variable blockDone, blockReplayed;
+  // at most this many blocks are buffered at a time
+  size_t window = 2 * size_t(params.threads);
+  size_t replayed = 0;
+
+  vector<std::thread> workers;
+  for (int w = 0; w < params.threads; w++) {
+    workers.emplace_back([&]() {
+      while (true) {
+        size_t b = nextBlock++;
+        if (b >= blockCount) break;
+        {
+          std::unique_lock<std::mutex> lock(mutex);
+          blockReplayed.wait(lock, [&]() {
+            return b < replayed + window || failed || stopped;
+          });
+        }
+        unique_ptr<EdgeClauseBuffer> buffer(new EdgeClauseBuffer(model, firstPlaceholder));
+        try {
+          for (int i = starts[b]; i < starts[b + 1] && !failed && !stopped; i++) {
+            bufferEdge(*buffer, inputGraph, i, params);
+          }
+        } catch (...) {
+          failed = true;
+        }
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          buffers[b] = std::move(buffer);
+          done[b] = true;
+        }
+        blockDone.notify_all();
       }
+    });
+  }
 
-      model.addAdjVar(i, j);
+  for (size_t b = 0; b < blockCount && !failed; b++) {
+    if (terminate && terminate()) {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopped = true;
+      break;
     }
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      blockDone.wait(lock, [&]() {
+        return done[b];
+      });
+    }
+    if (failed) break;
+    buffers[b]->replay(model);
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      buffers[b].reset();
+      replayed = b + 1;
+    }
+    blockReplayed.notify_all();
+  }
+  if (failed || stopped) {
+    blockReplayed.notify_all();
   }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  CHECK(!failed, "cannot encode the edge pairs");
+}
+
+void encodeAdjacent(SATModel& model, InputGraph& inputGraph, int pageCount) {
+  int n = inputGraph.nc;
+
+  //create variables
+  model.addAdjVars(n);
 
   // v(i,j) => i < j
   for (int i = 0; i < n; i++) {
@@ -460,7 +765,7 @@ void encodeAdjacent(SATModel& model, InputGraph& inputGraph, int pageCount) {
         continue;
       }
 
-      model.addClause(MClause(model.getAdjVar(i, j, false), model.getRelVar(i, j, true)));
+      model.addClause({model.getAdjVar(i, j, false), model.getRelVar(i, j, true)});
     }
   }
 
@@ -491,42 +796,44 @@ void encodeAdjacent(SATModel& model, InputGraph& inputGraph, int pageCount) {
           continue;
         }
 
-        model.addClause(MClause(model.getRelVar(i, x, false), model.getRelVar(x, j, false), model.getAdjVar(i, j, false)));
+        model.addClause({model.getRelVar(i, x, false), model.getRelVar(x, j, false), model.getAdjVar(i, j, false)});
       }
     }
   }
 }
 
-void encodeStack(SATModel& model, InputGraph& inputGraph, Params params) {
+void encodeStack(SATModel& model, InputGraph& inputGraph, Params params, const std::function<bool()>& terminate) {
   CHECK(params.isStack());
-  encodeRelative(model, inputGraph);
-  encodePageVariables(model, inputGraph, params.stacks);
+  encodeRelative(model, inputGraph, params);
+  encodePageVariables(model, inputGraph, params, params.stacks);
 
-  for (size_t i = 0; i < inputGraph.edges.size(); i++) {
-    encodeStackEdge(model, inputGraph, i, params);
+  if (inputGraph.fixedPages.empty()) {
+    encodeEdges(model, inputGraph, params, terminate, encodeStackEdge<SATModel>, encodeStackEdge<EdgeClauseBuffer>);
+  } else {
+    encodeEdges(model, inputGraph, params, terminate, encodeFixedPageEdge<SATModel>, encodeFixedPageEdge<EdgeClauseBuffer>);
   }
 }
 
-void encodeQueue(SATModel& model, InputGraph& inputGraph, Params params) {
+void encodeQueue(SATModel& model, InputGraph& inputGraph, Params params, const std::function<bool()>& terminate) {
   CHECK(params.isQueue());
-  encodeRelative(model, inputGraph);
-  encodePageVariables(model, inputGraph, params.queues);
+  encodeRelative(model, inputGraph, params);
+  encodePageVariables(model, inputGraph, params, params.queues);
 
-  for (size_t i = 0; i < inputGraph.edges.size(); i++) {
-    encodeQueueEdge(model, inputGraph, i, params);
+  if (inputGraph.fixedPages.empty()) {
+    encodeEdges(model, inputGraph, params, terminate, encodeQueueEdge<SATModel>, encodeQueueEdge<EdgeClauseBuffer>);
+  } else {
+    encodeEdges(model, inputGraph, params, terminate, encodeFixedPageEdge<SATModel>, encodeFixedPageEdge<EdgeClauseBuffer>);
   }
 }
 
-void encodeTrack(SATModel& model, InputGraph& inputGraph, Params params) {
+void encodeTrack(SATModel& model, InputGraph& inputGraph, Params params, const std::function<bool()>& terminate) {
   CHECK(params.isTrack());
-  encodeRelative(model, inputGraph);
+  encodeRelative(model, inputGraph, params);
   CHECK(params.stacks > 0, "hmm");
-  encodePageVariables(model, inputGraph, params.stacks);
-  encodeTrackVariables(model, inputGraph, params.tracks);
+  encodePageVariables(model, inputGraph, params, params.stacks);
+  encodeTrackVariables(model, inputGraph, params, params.tracks);
 
-  for (size_t i = 0; i < inputGraph.edges.size(); i++) {
-    encodeTrackEdge(model, inputGraph, i, params);
-  }
+  encodeEdges(model, inputGraph, params, terminate, encodeTrackEdge<SATModel>, encodeTrackEdge<EdgeClauseBuffer>);
 
   if (params.span > 0) {
     // adding span constraints
@@ -539,8 +846,8 @@ void encodeTrack(SATModel& model, InputGraph& inputGraph, Params params) {
       for (int i = 0; i < params.tracks; i++) {
         for (int j = i + 1; j < params.tracks; j++) {
           if (j - i > params.span) {
-            model.addClause(MClause(model.getTrackVar(u, i, false), model.getTrackVar(v, j, false)));
-            model.addClause(MClause(model.getTrackVar(u, j, false), model.getTrackVar(v, i, false)));
+            model.addClause({model.getTrackVar(u, i, false), model.getTrackVar(v, j, false)});
+            model.addClause({model.getTrackVar(u, j, false), model.getTrackVar(v, i, false)});
           }
         }
       }
@@ -548,38 +855,43 @@ void encodeTrack(SATModel& model, InputGraph& inputGraph, Params params) {
   }
 }
 
-void encodeMixed(SATModel& model, InputGraph& inputGraph, Params params) {
+void encodeMixed(SATModel& model, InputGraph& inputGraph, Params params, const std::function<bool()>& terminate) {
   CHECK(params.isMixed());
   CHECK(params.stacks >= 1 && params.queues >= 1, "incorrect page number for mixed layout");
-  encodeRelative(model, inputGraph);
-  encodePageVariables(model, inputGraph, params.stacks + params.queues);
+  encodeRelative(model, inputGraph, params);
+  encodePageVariables(model, inputGraph, params, params.stacks + params.queues);
 
   // page assignment:
   //   [0, params.stacks) are for stacks
   //   [params.stacks, params.stacks + params.queues) are for queues
-  for (size_t i = 0; i < inputGraph.edges.size(); i++) {
-    encodeMixedEdge(model, inputGraph, i, params);
+  if (inputGraph.fixedPages.empty()) {
+    encodeEdges(model, inputGraph, params, terminate, encodeMixedEdge<SATModel>, encodeMixedEdge<EdgeClauseBuffer>);
+  } else {
+    encodeEdges(model, inputGraph, params, terminate, encodeFixedPageEdge<SATModel>, encodeFixedPageEdge<EdgeClauseBuffer>);
   }
 }
 
-void encodeMixedPage(SATModel& model, InputGraph& inputGraph, Params params) {
+void encodeMixedPage(SATModel& model, InputGraph& inputGraph, Params params, const std::function<bool()>& terminate) {
   CHECK(params.isMixedPages());
   CHECK(params.stacks == 0 && params.queues == 0, "incorrect page number for mixed-page layout");
 
-  encodeRelative(model, inputGraph);
-  encodePageVariables(model, inputGraph, params.mixedPages);
+  encodeRelative(model, inputGraph, params);
+  encodePageVariables(model, inputGraph, params, params.mixedPages);
 
   // add page types
-  for (int i = 0; i < params.mixedPages; i++) {
-    model.addPageTypeVar(i);
-  }
+  model.addPageTypeVars(params.mixedPages);
 
-  for (size_t i = 0; i < inputGraph.edges.size(); i++) {
-    encodeMixedPageEdge(model, inputGraph, i, params);
-  }
+  encodeEdges(model, inputGraph, params, terminate, encodeMixedPageEdge<SATModel>, encodeMixedPageEdge<EdgeClauseBuffer>);
 }
 
-void encodeAutomorphismConstraints(SATModel& model, InputGraph& inputGraph, Params params) {
+// the refinements of the automorphism search before it gives up
+const size_t MAX_AUTOMORPHISM_NODES = 20000;
+// the relative-order variables compared by a lex-leader constraint
+const int MAX_LEX_LEADER_LENGTH = 100;
+
+// orders the vertices with identical neighbourhoods (except for vertices 0, 1 and 2,
+// which are fixed by the layout-specific constraints)
+void encodeTwinConstraints(SATModel& model, InputGraph& inputGraph, Params params) {
   int n = inputGraph.nc;
   map<int, vector<int> > adj;
 
@@ -612,8 +924,7 @@ void encodeAutomorphismConstraints(SATModel& model, InputGraph& inputGraph, Para
 
     for (size_t i = 0; i < group.size(); i++) {
       for (size_t j = i + 1; j < group.size(); j++) {
-        //cerr << (group[i] + 1) << " " << (group[j] + 1) << "\n";
-        model.addClause(MClause(model.getRelVar(group[i], group[j], true)));
+        inputGraph.addNodeRel(group[i], group[j]);
       }
     }
   }
@@ -621,10 +932,222 @@ void encodeAutomorphismConstraints(SATModel& model, InputGraph& inputGraph, Para
   LOG_IF(params.verbose && cnt > 0, "identified %d similarity groups...", cnt);
 }
 
+// generators of the automorphisms of the graph that fix the pinned vertices
+vector<vector<int>> findAutomorphisms(const InputGraph& inputGraph, Params params, const vector<int>& pinned) {
+  int n = inputGraph.nc;
+  vector<pair<int, int>> arcs;
+  for (size_t i = 0; i < inputGraph.edges.size(); i++) {
+    auto edge = inputGraph.edges[i];
+    if (params.directed && !inputGraph.direction[i]) {
+      swap(edge.first, edge.second);
+    }
+    arcs.push_back(edge);
+  }
+
+  // the colours of the input, and a distinct one for every pinned vertex
+  map<int, int> colorIndex;
+  for (auto& pr : inputGraph.color) {
+    colorIndex[pr.second] = 0;
+  }
+  int numColors = 1;
+  for (auto& pr : colorIndex) {
+    pr.second = numColors++;
+  }
+  vector<int> colors(n, 0);
+  for (auto& pr : inputGraph.color) {
+    colors[pr.first] = colorIndex[pr.second];
+  }
+  for (int v : pinned) {
+    colors[v] = numColors++;
+  }
+
+  bool complete;
+  auto generators = automorphismGenerators(n, arcs, params.directed, colors, MAX_AUTOMORPHISM_NODES, complete);
+  LOG_IF(params.verbose >= 2 && !complete, "the automorphism search is incomplete");
+  return generators;
+}
+
+// the vertex in the smallest orbit of the generators that is not pinned yet
+int smallestOrbitVertex(int n, const vector<vector<int>>& generators, const vector<int>& pinned) {
+  vector<int> orbit = automorphismOrbits(n, generators);
+  vector<int> orbitSize(n, 0);
+  for (int v = 0; v < n; v++) {
+    orbitSize[orbit[v]]++;
+  }
+  int best = -1;
+  for (int v = 0; v < n; v++) {
+    if (find(pinned.begin(), pinned.end(), v) != pinned.end()) continue;
+    if (best == -1 || orbitSize[orbit[v]] < orbitSize[orbit[best]]) {
+      best = v;
+    }
+  }
+  return best;
+}
+
+// Breaks the automorphisms of the graph by lex-leader constraints. The layout-specific
+// constraints fix vertices of the spine (the first vertex of stack layouts and the pair
+// directing the spine); they are chosen in the smallest orbits, so that many automorphisms
+// fix them. A solution is rotated/reversed to satisfy the layout constraints, and then
+// mapped to the lex-leader of its orbit under the automorphisms fixing these vertices,
+// which keeps the layout constraints. Permuting the pages (tracks) comes last and does
+// not change the relative order. The searches stop once terminate() is true, leaving the
+// model incomplete
+void encodeAutomorphismConstraints(SATModel& model, InputGraph& inputGraph, Params params, const std::function<bool()>& terminate) {
+  int n = inputGraph.nc;
+  vector<int> pinned;
+  auto generators = findAutomorphisms(inputGraph, params, pinned);
+  if (generators.empty() || (terminate && terminate())) {
+    return;
+  }
+
+  if (params.isStack()) {
+    inputGraph.firstNode = smallestOrbitVertex(n, generators, pinned);
+    pinned.push_back(inputGraph.firstNode);
+    generators = findAutomorphisms(inputGraph, params, pinned);
+    if (terminate && terminate()) return;
+  }
+  bool directed = !params.isTrack() || params.span == 0;
+  if (n >= 3 && directed) {
+    int first = smallestOrbitVertex(n, generators, pinned);
+    pinned.push_back(first);
+    generators = findAutomorphisms(inputGraph, params, pinned);
+    if (terminate && terminate()) return;
+    int second = smallestOrbitVertex(n, generators, pinned);
+    pinned.push_back(second);
+    generators = findAutomorphisms(inputGraph, params, pinned);
+    if (terminate && terminate()) return;
+    inputGraph.spineDirection = make_pair(first, second);
+  }
+
+  inputGraph.automorphisms = generators;
+  LOG_IF(params.verbose && !generators.empty(), "identified %zu automorphism generators...", generators.size());
+
+  // interchangeable vertices: the same neighbours and colour, and not pinned
+  map<tuple<int, vector<int>, vector<int>>, vector<int>> groups;
+  vector<vector<int>> out(n), in(n);
+  for (size_t i = 0; i < inputGraph.edges.size(); i++) {
+    auto edge = inputGraph.edges[i];
+    if (params.directed && !inputGraph.direction[i]) {
+      swap(edge.first, edge.second);
+    }
+    out[edge.first].push_back(edge.second);
+    (params.directed ? in : out)[edge.second].push_back(edge.first);
+  }
+  for (int v = 0; v < n; v++) {
+    if (find(pinned.begin(), pinned.end(), v) != pinned.end()) continue;
+    sort(out[v].begin(), out[v].end());
+    sort(in[v].begin(), in[v].end());
+    auto it = inputGraph.color.find(v);
+    int color = it == inputGraph.color.end() ? -1 : it->second;
+    groups[make_tuple(color, out[v], in[v])].push_back(v);
+  }
+  for (auto& pr : groups) {
+    auto& group = pr.second;
+    if (group.size() <= 1) continue;
+    for (size_t i = 0; i < group.size(); i++) {
+      for (size_t j = i + 1; j < group.size(); j++) {
+        inputGraph.addNodeRel(group[i], group[j]);
+      }
+    }
+    inputGraph.twins.push_back(group);
+  }
+  LOG_IF(params.verbose && !inputGraph.twins.empty(), "identified %zu similarity groups...", inputGraph.twins.size());
+}
+
+// x <=lex x o gen over the relative-order variables, where the automorphism maps rel(i, j)
+// to rel(gen[i], gen[j]). The variables are ordered as rel(t_j, t_i) for the pairs t_i < t_j
+// of every twin class, followed by the other pairs (i, j), i < j, in lexicographic order;
+// the lex-leader of this order sorts the twins, so their nodeRel constraints and the
+// constraints of all generators are implied by it. eq is implied if the compared prefix
+// equals its image
+void encodeLexLeader(SATModel& model, const vector<int>& gen, const vector<vector<int>>& twins) {
+  int n = int(gen.size());
+  vector<int> moved;
+  for (int v = 0; v < n; v++) {
+    if (gen[v] != v) {
+      moved.push_back(v);
+    }
+  }
+  vector<int> twinClass(n, -1);
+  for (size_t c = 0; c < twins.size(); c++) {
+    for (int v : twins[c]) {
+      twinClass[v] = int(c);
+    }
+  }
+
+  MVar eq(0, true);
+  bool hasEq = false;
+  int length = 0;
+  auto compare = [&](int i, int j) {
+    MVar a = model.getRelVar(i, j, true);
+    MVar b = model.getRelVar(gen[i], gen[j], true);
+    int knownA = model.knownValue(a);
+    int knownB = model.knownValue(b);
+    if (a.lit == b.lit || (knownA != 0 && knownA == knownB)) {
+      return true;
+    }
+
+    MClause clause;
+    if (hasEq) {
+      clause.addVar(MVar(eq.id(), false));
+    }
+    clause.addVar(MVar(a.id(), !a.positive()));
+    if (a.lit == -b.lit || (knownA != 0 && knownB != 0)) {
+      // the image differs from the variable, so the prefix has to be smaller
+      model.addClause(clause);
+      return false;
+    }
+    clause.addVar(b);
+    model.addClause(clause);
+    if (++length == MAX_LEX_LEADER_LENGTH) {
+      return false;
+    }
+
+    MVar next(model.addVar(), true);
+    MClause bothTrue, bothFalse;
+    if (hasEq) {
+      bothTrue.addVar(MVar(eq.id(), false));
+      bothFalse.addVar(MVar(eq.id(), false));
+    }
+    bothTrue.addVar(MVar(a.id(), !a.positive()));
+    bothTrue.addVar(next);
+    bothFalse.addVar(b);
+    bothFalse.addVar(next);
+    model.addClause(bothTrue);
+    model.addClause(bothFalse);
+    eq = next;
+    hasEq = true;
+    return true;
+  };
+
+  for (auto& group : twins) {
+    for (size_t x = 0; x < group.size(); x++) {
+      for (size_t y = x + 1; y < group.size(); y++) {
+        int i = group[x];
+        int j = group[y];
+        if ((gen[i] != i || gen[j] != j) && !compare(j, i)) return;
+      }
+    }
+  }
+
+  // the other pairs with a moved vertex
+  for (int i = 0; i < n; i++) {
+    if (gen[i] != i) {
+      for (int j = i + 1; j < n; j++) {
+        if ((twinClass[i] == -1 || twinClass[i] != twinClass[j]) && !compare(i, j)) return;
+      }
+    } else {
+      for (int j : moved) {
+        if (j > i && (twinClass[i] == -1 || twinClass[i] != twinClass[j]) && !compare(i, j)) return;
+      }
+    }
+  }
+}
+
 void encodeStackSymmetry(SATModel& model, InputGraph& inputGraph, Params params) {
   int n = inputGraph.nc;
 
-  // set node 1 as the first one on the spine
+  // set the first node on the spine
   for (int i = 0; i < n; i++) {
     if (i == inputGraph.firstNode) {
       continue;
@@ -633,12 +1156,12 @@ void encodeStackSymmetry(SATModel& model, InputGraph& inputGraph, Params params)
     inputGraph.addNodeRel(inputGraph.firstNode, i);
   }
 
-  // set the direction of the spine: 1 < 2
+  // set the direction of the spine (1 < 2 by default)
   if (n >= 3) {
-    inputGraph.addNodeRel(1, 2);
+    inputGraph.addNodeRel(inputGraph.spineDirection.first, inputGraph.spineDirection.second);
   }
 
-  if (!params.dispersible) {
+  if (!params.dispersible && inputGraph.fixedPages.empty()) {
     // edge 0 on the first page
     inputGraph.edgePages[0] = {0};
 
@@ -652,12 +1175,12 @@ void encodeStackSymmetry(SATModel& model, InputGraph& inputGraph, Params params)
 void encodeQueueSymmetry(SATModel& model, InputGraph& inputGraph, Params params) {
   int n = inputGraph.nc;
 
-  // set the direction of the spine: 1 < 2
+  // set the direction of the spine (1 < 2 by default)
   if (n >= 3) {
-    inputGraph.addNodeRel(1, 2);
+    inputGraph.addNodeRel(inputGraph.spineDirection.first, inputGraph.spineDirection.second);
   }
 
-  if (!params.dispersible) {
+  if (!params.dispersible && inputGraph.fixedPages.empty()) {
     // edge 0 on the first page
     inputGraph.edgePages[0] = {0};
 
@@ -707,8 +1230,8 @@ void encodeQueueSymmetry(SATModel& model, InputGraph& inputGraph, Params params)
 
     for (size_t j1 = 0; j1 < adjEdges.size(); j1++) {
       for (size_t j2 = j1 + 1; j2 < adjEdges.size(); j2++) {
-        model.addClause( MClause(MVar(rightmostVar[i], false), model.getSamePageVar(adjEdges[j1], adjEdges[j2], true)) );
-        model.addClause( MClause(MVar(leftmostVar[i], false), model.getSamePageVar(adjEdges[j1], adjEdges[j2], true)) );
+        model.addClause({MVar(rightmostVar[i], false), model.getSamePageVar(adjEdges[j1], adjEdges[j2], true)});
+        model.addClause({MVar(leftmostVar[i], false), model.getSamePageVar(adjEdges[j1], adjEdges[j2], true)});
       }
     }
   }*/
@@ -723,8 +1246,10 @@ void encodeTrackSymmetry(SATModel& model, InputGraph& inputGraph, Params params)
       }
     }
 
-    // set the direction of the spine: 1 < 2
-    inputGraph.addNodeRel(1, 2);
+    // set the direction of the spine (1 < 2 by default)
+    if (inputGraph.nc >= 3) {
+      inputGraph.addNodeRel(inputGraph.spineDirection.first, inputGraph.spineDirection.second);
+    }
     // int f = inputGraph.firstNode;
     // inputGraph.nodeTracks[f].push_back(0);
     // int x = -1;
@@ -739,26 +1264,34 @@ void encodeTrackSymmetry(SATModel& model, InputGraph& inputGraph, Params params)
 }
 
 void encodeMixedSymmetry(SATModel& model, InputGraph& inputGraph, Params params) {
-  // set the direction of the spine: 1 < 2
+  // set the direction of the spine (1 < 2 by default)
   if (inputGraph.nc >= 3) {
-    auto rel = make_pair(1, 2);
-    inputGraph.nodeRel.push_back(rel);
+    inputGraph.nodeRel.push_back(inputGraph.spineDirection);
   }
 }
 
 void encodeMixedPagesSymmetry(SATModel& model, InputGraph& inputGraph, Params params) {
-  // set the direction of the spine: 1 < 2
+  // set the direction of the spine (1 < 2 by default)
   if (inputGraph.nc >= 3) {
-    auto rel = make_pair(1, 2);
-    inputGraph.nodeRel.push_back(rel);
+    inputGraph.nodeRel.push_back(inputGraph.spineDirection);
   }
 }
 
-void encodeCustomConstraints(SATModel& model, InputGraph& inputGraph, Params params) {
+// adds symmetry-breaking constraints to the input graph; they are fixed by the encoders
+void prepareCustomConstraints(SATModel& model, InputGraph& inputGraph, Params params, const std::function<bool()>& terminate) {
   // Basic symmetryc-breaking constraints
-  if (inputGraph.numCustomConstraints() == 0 && !params.applyBreakID) {
+  if (inputGraph.numCustomConstraints() == 0 && params.breakSymmetry) {
     LOG_IF(params.verbose, "adding symmetry-breaking constraints");
 
+    // breaking symmetry: lex-leader constraints for the automorphisms of the graph; the
+    // encodings of trees, multi-page edges and fixed pages are not invariant under them
+    bool multiPage = find(inputGraph.multiPage.begin(), inputGraph.multiPage.end(), true) != inputGraph.multiPage.end();
+    bool fixedPages = !inputGraph.fixedPages.empty();
+    bool lexLeader = params.applyBreakID && !params.trees && !multiPage && !fixedPages;
+    if (lexLeader) {
+      encodeAutomorphismConstraints(model, inputGraph, params, terminate);
+    }
+
     if (params.isStack()) {
       // STACK
       encodeStackSymmetry(model, inputGraph, params);
@@ -777,12 +1310,16 @@ void encodeCustomConstraints(SATModel& model, InputGraph& inputGraph, Params par
     }
 
     // breaking symmetry: relative order for isomorphic vertices
-    encodeAutomorphismConstraints(model, inputGraph, params);
+    if (!lexLeader && !fixedPages) {
+      encodeTwinConstraints(model, inputGraph, params);
+    }
   } else if (inputGraph.numCustomConstraints() > 0) {
     size_t numCons = inputGraph.numCustomConstraints();
     LOG_IF(params.verbose, "encoding %zu custom constraints...", numCons);
   }
+}
 
+void encodeCustomConstraints(SATModel& model, InputGraph& inputGraph, Params params) {
   // Custom Constraints
   LOG_IF(params.verbose >= 2, "encoding %zu nodeRel constraints...", inputGraph.nodeRel.size());
   for (size_t i = 0; i < inputGraph.nodeRel.size(); i++) {
@@ -796,9 +1333,9 @@ void encodeCustomConstraints(SATModel& model, InputGraph& inputGraph, Params par
 
     // hmmm
     if (!params.isTrack() || true) {
-      model.addClause(MClause(model.getRelVar(l, r, true)));
+      model.addClause({model.getRelVar(l, r, true)});
     } else {
-      model.addClause(MClause(model.getRelVar(l, r, true), model.getSameTrackVar(l, r, false)));
+      model.addClause({model.getRelVar(l, r, true), model.getSameTrackVar(l, r, false)});
     }
   }
 
@@ -820,13 +1357,13 @@ void encodeCustomConstraints(SATModel& model, InputGraph& inputGraph, Params par
   for (auto pr : inputGraph.samePage) {
     int e1 = pr.first;
     int e2 = pr.second;
-    model.addClause(MClause(model.getSamePageVar(e1, e2, true)));
+    model.addClause({model.getSamePageVar(e1, e2, true)});
   }
 
   for (auto pr : inputGraph.distinctPage) {
     int e1 = pr.first;
     int e2 = pr.second;
-    model.addClause(MClause(model.getSamePageVar(e1, e2, false)));
+    model.addClause({model.getSamePageVar(e1, e2, false)});
   }
 
   for (auto pr : inputGraph.nodeTracks) {
@@ -853,8 +1390,8 @@ void encodeCustomConstraints(SATModel& model, InputGraph& inputGraph, Params par
     CHECK(0 <= u2 && u2 < inputGraph.nc);
     CHECK(0 <= v2 && v2 < inputGraph.nc);
 
-    model.addClause(MClause(model.getRelVar(u1, v1, true), model.getRelVar(u2, v2, false)));
-    model.addClause(MClause(model.getRelVar(u1, v1, false), model.getRelVar(u2, v2, true)));
+    model.addClause({model.getRelVar(u1, v1, true), model.getRelVar(u2, v2, false)});
+    model.addClause({model.getRelVar(u1, v1, false), model.getRelVar(u2, v2, true)});
   }  
 
   int pageCount = params.stacks + params.queues + params.mixedPages;
@@ -869,7 +1406,7 @@ void encodeCustomConstraints(SATModel& model, InputGraph& inputGraph, Params par
         int allOnKVar = model.addVar();
         // all on page K     => i on page K and j on page K
         for (int edgeIdx : edgeIndices) {
-          model.addClause(MClause(MVar(allOnKVar, false), model.getPageVar(edgeIdx, page, true)));
+          model.addClause({MVar(allOnKVar, false), model.getPageVar(edgeIdx, page, true)});
         }
         clause.addVar(MVar(allOnKVar, true));
       }
@@ -891,7 +1428,7 @@ void encodeCustomConstraints(SATModel& model, InputGraph& inputGraph, Params par
             int e1 = edgeIndices[i1];
             int e2 = edgeIndices[i2];
             int e3 = edgeIndices[i3];
-            model.addClause(MClause(model.getSamePageVar(e1, e2, true), model.getSamePageVar(e1, e3, true), model.getSamePageVar(e2, e3, true)));
+            model.addClause({model.getSamePageVar(e1, e2, true), model.getSamePageVar(e1, e3, true), model.getSamePageVar(e2, e3, true)});
           }
         }
       }
@@ -899,6 +1436,11 @@ void encodeCustomConstraints(SATModel& model, InputGraph& inputGraph, Params par
       ERROR("larger values of k are not implemented");
     }
   }
+
+  LOG_IF(params.verbose >= 2, "encoding %zu lex-leader constraints...", inputGraph.automorphisms.size());
+  for (auto& gen : inputGraph.automorphisms) {
+    encodeLexLeader(model, gen, inputGraph.twins);
+  }
 }
 
 void encodeTrees(SATModel& model, InputGraph& inputGraph, Params& params);
@@ -1112,27 +1654,39 @@ void printResult(InputGraph& inputGraph, Params& params, const std::vector<int>&
   }
 }
 
-bool fillResult(InputGraph& inputGraph, Params& params, SATModel& model) {
+bool fillLayout(InputGraph& inputGraph, Params& params, SATModel& model, Layout& layout) {
   // vertices are in [0..nc)
-  std::vector<int> order;
+  std::vector<int>& order = layout.order;
   // pages are in [0..pages)
-  std::vector<int> pages;
+  std::vector<int>& pages = layout.pages;
   // tracks are in [0..tracks)
-  std::vector<int> tracks;
+  std::vector<int>& tracks = layout.tracks;
 
   // fill order
+  // a vertex preceding k others is at position n-k-1; the positions are distinct only
+  // if the relative order is transitive
   order = std::vector<int>(inputGraph.nc, -1);
+  vector<int> precedes(inputGraph.nc, 0);
   for (int i = 0; i < inputGraph.nc; i++) {
-    int countSmaller = 0;
-    for (int j = 0; j < inputGraph.nc; j++) {
-      if (i != j && model.value(model.getRelVar(i, j, true))) countSmaller++;
+    for (int j = i + 1; j < inputGraph.nc; j++) {
+      if (model.value(model.getRelVar(i, j, true))) {
+        precedes[i]++;
+      } else {
+        precedes[j]++;
+      }
     }
-    CHECK(order[inputGraph.nc - countSmaller - 1] == -1);
-    order[inputGraph.nc - countSmaller - 1] = i;
+  }
+  for (int i = 0; i < inputGraph.nc; i++) {
+    int position = inputGraph.nc - precedes[i] - 1;
+    CHECK(order[position] == -1, "relative order is not transitive");
+    order[position] = i;
   }
 
   // fill edge pages
-  for (size_t j = 0; j < inputGraph.edges.size(); j++) {
+  if (!inputGraph.fixedPages.empty()) {
+    pages = inputGraph.fixedPages;
+  }
+  for (size_t j = 0; j < inputGraph.edges.size() && inputGraph.fixedPages.empty(); j++) {
     bool multi = inputGraph.multiPage.size() == inputGraph.edges.size() && inputGraph.multiPage[j];
     int page = -1;
     int cnt = 0;
@@ -1180,13 +1734,215 @@ bool fillResult(InputGraph& inputGraph, Params& params, SATModel& model) {
       tracks.push_back(track);
     }
   }
-
-  printResult(inputGraph, params, order, pages, tracks);
   return true;
 }
 
-bool runInternal(InputGraph& inputGraph, Params params) {
-  CHECK(!params.skipSAT);
+// FNV-1a hash of the graph; identifies the graph a variable map was created for
+uint64_t graphHash(const InputGraph& inputGraph) {
+  uint64_t hash = 14695981039346656037ULL;
+  auto mix = [&](uint64_t value) {
+    for (int i = 0; i < 8; i++) {
+      hash ^= (value >> (8 * i)) & 0xff;
+      hash *= 1099511628211ULL;
+    }
+  };
+
+  mix(inputGraph.nc);
+  mix(inputGraph.edges.size());
+  for (size_t i = 0; i < inputGraph.edges.size(); i++) {
+    mix(inputGraph.edges[i].first);
+    mix(inputGraph.edges[i].second);
+    mix(inputGraph.multiPage.size() == inputGraph.edges.size() && inputGraph.multiPage[i]);
+    if (!inputGraph.fixedPages.empty()) {
+      mix(inputGraph.fixedPages[i]);
+    }
+  }
+  return hash;
+}
+
+// the parameters that determine the variable numbering of a model
+std::string varMapSignature(const InputGraph& inputGraph, const Params& params) {
+  std::ostringstream ss;
+  ss << "graph " << inputGraph.nc << " " << inputGraph.edges.size() << " " << std::hex << graphHash(inputGraph) << std::dec << "\n";
+  ss << "params " << int(params.embedding) << " " << params.stacks << " " << params.queues << " " << params.tracks << " " << params.mixedPages;
+  ss << " " << params.span << " " << params.strict << " " << params.custom << " " << params.toString() << "\n";
+  return ss.str();
+}
+
+// the sidecar of a model: its signature followed by the variable layout and the
+// reconstruction stack of the preprocessor
+void writeVarMap(const InputGraph& inputGraph, const Params& params, const SATModel& model, const ReconstructionStack* stack) {
+  std::ofstream out(params.mapFile);
+  CHECK(out.good(), "cannot open '" + params.mapFile + "' for writing");
+  out << varMapSignature(inputGraph, params);
+  model.writeVarMap(out);
+  if (stack != nullptr) {
+    stack->write(out);
+  }
+  out.close();
+  CHECK(!out.fail(), "cannot write '" + params.mapFile + "'");
+}
+
+void readVarMap(const InputGraph& inputGraph, const Params& params, SATModel& model, ReconstructionStack& stack) {
+  std::ifstream in(params.mapFile);
+  CHECK(in.good(), "cannot open '" + params.mapFile + "'");
+
+  std::string expected = varMapSignature(inputGraph, params);
+  std::istringstream signature(expected);
+  std::string line, expectedLine;
+  while (std::getline(signature, expectedLine)) {
+    std::getline(in, line);
+    CHECK(!in.fail(), "incorrect variable map in '" + params.mapFile + "'");
+    CHECK(line == expectedLine, "variable map '" + params.mapFile + "' was created for another graph or parameters");
+  }
+
+  std::stringstream layout;
+  while (std::getline(in, line)) {
+    if (line.compare(0, 5, "elim ") == 0) {
+      stack.readLine(line);
+    } else {
+      layout << line << "\n";
+    }
+  }
+  model.readVarMap(layout);
+}
+
+// extends the solution to the eliminated variables and reads the layout
+void decodeLayout(InputGraph& inputGraph, Params& params, SATModel& model, const ReconstructionStack* stack, Layout& layout) {
+  if (stack != nullptr) {
+    stack->extend(model.externalVars);
+  }
+  CHECK(fillLayout(inputGraph, params, model, layout), "cannot construct layout from SAT assignment");
+}
+
+// decodes the layout and prints it
+void decodeSolution(InputGraph& inputGraph, Params& params, SATModel& model, const ReconstructionStack* stack) {
+  Layout layout;
+  decodeLayout(inputGraph, params, model, stack, layout);
+  printResult(inputGraph, params, layout.order, layout.pages, layout.tracks);
+}
+
+// decodes a solver result using the variable map, without encoding the model
+bool decodeWithVarMap(InputGraph& inputGraph, Params& params) {
+  SATModel model;
+  ReconstructionStack stack;
+  readVarMap(inputGraph, params, model, stack);
+  LOG_IF(params.verbose, "read variable map with %d variables from '%s'", model.varCount(), params.mapFile.c_str());
+
+  auto externalResult = model.fromDimacs(params.resultFile);
+  if (externalResult == "SATISFIABLE") {
+    decodeSolution(inputGraph, params, model, &stack);
+    return true;
+  }
+
+  CHECK(externalResult == "UNSATISFIABLE", "unexpected SAT status: " + externalResult);
+  return false;
+}
+
+// keeps the variables used for decoding a result in the preprocessed model
+void freezeDecodedVars(const SATModel& model, CnfPreprocessor& preprocessor) {
+  for (VarFamily family : {REL_VARS, PAGE_VARS, TRACK_VARS, SAME_TRACK_VARS, PAGE_TYPE_VARS}) {
+    auto& block = model.getBlock(family);
+    if (!block.exists()) continue;
+    for (size_t i = 0; i < block.size(); i++) {
+      preprocessor.freeze(block.first + int(i));
+    }
+  }
+}
+
+// the vertices ordered by the number of vertices they precede in the solution; in a
+// transitive order, this is the order itself
+vector<int> rankVertices(const SATModel& model, int n) {
+  vector<int> precedes(n, 0);
+  for (int i = 0; i < n; i++) {
+    for (int j = i + 1; j < n; j++) {
+      if (model.value(model.getRelVar(i, j, true))) {
+        precedes[i]++;
+      } else {
+        precedes[j]++;
+      }
+    }
+  }
+  vector<int> order(n);
+  for (int i = 0; i < n; i++) {
+    order[i] = i;
+  }
+  std::stable_sort(order.begin(), order.end(), [&](int i, int j) {
+    return precedes[i] > precedes[j];
+  });
+  return order;
+}
+
+// adds the transitivity clauses of cyclic triples in the relative order of the solution,
+// one for every pair ordered inconsistently with the ranking; returns their number. A
+// witness is mostly found after a few steps, but the searches of a round are limited to
+// n^2 steps, which keeps the check in O(n^2) and still excludes the first inconsistent pair
+size_t addCyclicTriples(SATModel& model, const vector<int>& order) {
+  int n = int(order.size());
+  int64_t budget = int64_t(n) * n;
+  set<tuple<int, int, int>> triples;
+  for (int x = 0; x < n && budget > 0; x++) {
+    for (int y = x + 1; y < n && budget > 0; y++) {
+      int u = order[x];
+      int v = order[y];
+      if (model.value(model.getRelVar(u, v, true))) continue;
+
+      // v < u although u precedes at least as many vertices as v, so u < w < v for some w
+      int w = 0;
+      while (w < n && (w == u || w == v || !model.value(model.getRelVar(u, w, true)) || !model.value(model.getRelVar(w, v, true)))) {
+        w++;
+      }
+      CHECK(w < n);
+      budget -= w + 1;
+      int t[3] = {u, v, w};
+      std::sort(t, t + 3);
+      triples.insert(make_tuple(t[0], t[1], t[2]));
+    }
+  }
+
+  for (auto& t : triples) {
+    addTransitivityClauses(model, get<0>(t), get<1>(t), get<2>(t));
+  }
+  return triples.size();
+}
+
+// solves the model; with lazy transitivity, the cyclic triples of every solution are
+// excluded and the model is re-solved until the order is consistent. The solution is
+// copied to the model
+SatSolver::Result solveModel(const Params& params, SATModel& model, SatSolver& solver) {
+  int n = model.getBlock(REL_VARS).rows;
+  size_t added = 0;
+  for (int round = 1; ; round++) {
+    auto res = solver.solve();
+    if (res != SatSolver::SAT) {
+      return res;
+    }
+    model.fromSolver(solver);
+    if (!params.lazyTransitivity) break;
+
+    // the new clauses go to the solver through the model
+    vector<int> order = rankVertices(model, n);
+    size_t triples = addCyclicTriples(model, order);
+    LOG_IF(params.verbose >= 2, "round %d: %zu cyclic triples", round, triples);
+    if (triples == 0) {
+      LOG_IF(params.verbose, "lazy transitivity: %zu of %zu triples added in %d rounds",
+             added, size_t(n) * (n - 1) * (n - 2) / 6, round);
+      break;
+    }
+    added += triples;
+
+    // the next search starts from the ranking, which is transitive
+    for (int x = 0; x < n; x++) {
+      for (int y = x + 1; y < n; y++) {
+        solver.phase(model.getRelVar(order[x], order[y], true).lit);
+      }
+    }
+  }
+  return SatSolver::SAT;
+}
+
+// whether the lower bound on the number of pages (tracks) does not exclude a layout
+bool checkLowerBound(InputGraph& inputGraph, Params& params) {
   int lbPages = -1;
   int ubPages = params.isMixedPages() ? params.mixedPages : params.stacks + params.queues;
 
@@ -1214,29 +1970,48 @@ bool runInternal(InputGraph& inputGraph, Params params) {
     LOG_IF(params.verbose, "lower bound (%d) exceeds upper bound (%d)", lbPages, ubPages);
     return false;
   }
+  return true;
+}
 
-  SATModel model;
+// encodes all constraints into the model, whose sink has to be set; returns false if
+// terminate() became true, in which case the model is incomplete
+bool encodeModel(SATModel& model, InputGraph& inputGraph, Params& params, const std::function<bool()>& terminate = nullptr) {
+  auto stopped = [&terminate]() {
+    return terminate && terminate();
+  };
+  // orders and pages fixed by the constraints are known to the encoders
+  if (params.directed) {
+    LOG_IF(params.verbose, "encoding directed constraints...");
+    encodeDirectedConstraints(model, inputGraph, params);
+  }
+  prepareCustomConstraints(model, inputGraph, params, terminate);
+  if (stopped()) {
+    return false;
+  }
 
   // encoding
   if (!params.skipSolve) {
     if (params.isStack()) {
       LOG_IF(params.verbose, "encoding model for stack embedding...");
-      encodeStack(model, inputGraph, params);
+      encodeStack(model, inputGraph, params, terminate);
     } else if (params.isQueue()) {
       LOG_IF(params.verbose, "encoding model for queue embedding...");
-      encodeQueue(model, inputGraph, params);
+      encodeQueue(model, inputGraph, params, terminate);
     } else if (params.isTrack()) {
       LOG_IF(params.verbose, "encoding model for track embedding...");
-      encodeTrack(model, inputGraph, params);
+      encodeTrack(model, inputGraph, params, terminate);
     } else if (params.isMixed()) {
       LOG_IF(params.verbose, "encoding model for mixed embedding...");
-      encodeMixed(model, inputGraph, params);
+      encodeMixed(model, inputGraph, params, terminate);
     } else if (params.isMixedPages()) {
       LOG_IF(params.verbose, "encoding model for mixed-page embedding...");
-      encodeMixedPage(model, inputGraph, params);
+      encodeMixedPage(model, inputGraph, params, terminate);
     } else {
       ERROR("wrong type of layout");
     }
+    if (stopped()) {
+      return false;
+    }
   }
 
   if (params.trees) {
@@ -1249,11 +2024,6 @@ bool runInternal(InputGraph& inputGraph, Params params) {
     encodeAdjacent(model, inputGraph, params.stacks + params.queues);
   }
 
-  if (params.directed) {
-    LOG_IF(params.verbose, "encoding directed constraints...");
-    encodeDirectedConstraints(model, inputGraph, params);
-  }
-
   if (params.dispersible) {
     LOG_IF(params.verbose, "encoding dispersible constraints...");
     encodeDispersible(model, inputGraph, params);
@@ -1263,17 +2033,437 @@ bool runInternal(InputGraph& inputGraph, Params params) {
     LOG_IF(params.verbose, "encoding local constraints...");
     encodeLocal(model, inputGraph, params);
   }
-  
+
+  encodeCustomConstraints(model, inputGraph, params);
+
   LOG_IF(params.verbose, "encoded %d variables and %d constraints", model.varCount(), model.clauseCount());
+  if (params.verbose && model.samePagePairCount() > 0) {
+    int pageCount = params.isMixedPages() ? params.mixedPages : params.stacks + params.queues;
+    size_t pairs = model.samePageVarCount();
+    LOG("created same-page variables for %d of %d edge pairs", int(pairs), int(model.samePagePairCount()));
+    LOG("same-page linking (%s): %d clauses with the quadratic encoding, %d with the linear one",
+        linearSamePages(params, pageCount) ? "linear" : "quadratic", int(pairs * pageCount * pageCount), int(pairs * 2 * pageCount));
+  }
+  return !stopped();
+}
+
+// a model encoded into an in-process solver, optionally through the preprocessor
+struct SolverRun {
+  SATModel model;
+  std::unique_ptr<SatSolver> solver;
+  std::unique_ptr<CnfPreprocessor> preprocessor;
+
+  const ReconstructionStack* reconstruction() const {
+    return preprocessor ? &preprocessor->reconstruction() : nullptr;
+  }
+};
+
+// whether the model is streamed to an external solver while it is encoded; models that
+// are re-solved or preprocessed are kept in memory
+bool streamToSolver(const Params& params) {
+  return params.solver != "" && !params.lazyTransitivity && !params.preprocess;
+}
+
+// suggests the order and the pages of a layout as the initial values of the variables;
+// edges without a page keep their phases
+void addPhaseHint(const SATModel& model, SatSolver& solver, const Layout& hint) {
+  int n = int(hint.order.size());
+  for (int x = 0; x < n; x++) {
+    for (int y = x + 1; y < n; y++) {
+      solver.phase(model.getRelVar(hint.order[x], hint.order[y], true).lit);
+    }
+  }
+  auto& pageBlock = model.getBlock(PAGE_VARS);
+  if (!pageBlock.exists()) return;
+  for (size_t e = 0; e < hint.pages.size(); e++) {
+    if (hint.pages[e] == -1) continue;
+    for (int page = 0; page < pageBlock.cols; page++) {
+      solver.phase(model.getPageVar(int(e), page, page == hint.pages[e]).lit);
+    }
+  }
+}
+
+// encodes the model into a new solver and solves it, starting from the hint (if any); the
+// solver stops early if terminate() becomes true
+SatSolver::Result encodeAndSolve(InputGraph& inputGraph, Params& params, SolverRun& run, std::function<bool()> terminate, const Layout* hint = nullptr) {
+  if (streamToSolver(params)) {
+    // the header of the stream needs the counts, which come from a silent counting pass
+    // over a copy of the graph (the encoders add constraints to it)
+    InputGraph countGraph = inputGraph;
+    Params countParams = params;
+    countParams.verbose = 0;
+    SATModel countModel;
+    CountingSink counter;
+    countModel.setSink(&counter);
+    if (!encodeModel(countModel, countGraph, countParams, terminate)) {
+      return SatSolver::UNKNOWN;
+    }
+    run.solver.reset(new StreamingSolver(params.solver, int(countModel.varCount()), countModel.clauseCount()));
+  } else {
+    run.solver = createSolver(params.solver, params.seed);
+  }
+  run.solver->setTerminate(terminate);
+  if (params.preprocess) {
+    CHECK(!params.lazyTransitivity, "preprocessing is not supported with lazy transitivity");
+    run.preprocessor.reset(new CnfPreprocessor(run.solver.get(), params.verbose));
+    run.model.setSink(run.preprocessor.get());
+  } else {
+    run.model.setSink(run.solver.get());
+  }
+
+  if (!encodeModel(run.model, inputGraph, params, terminate)) {
+    return SatSolver::UNKNOWN;
+  }
+  if (run.preprocessor) {
+    freezeDecodedVars(run.model, *run.preprocessor);
+    run.preprocessor->finish(run.model.varCount(), run.model.clauseCount());
+  } else {
+    run.solver->finish(run.model.varCount(), run.model.clauseCount());
+  }
+  if (terminate && terminate()) {
+    return SatSolver::UNKNOWN;
+  }
+  if (hint != nullptr && !run.preprocessor) {
+    addPhaseHint(run.model, *run.solver, *hint);
+  }
+
+  string name = params.solver == "" ? "the bundled solver" : "'" + params.solver + "'";
+  LOG_IF(params.verbose, "solving the model with %s...", name.c_str());
+  return solveModel(params, run.model, *run.solver);
+}
+
+// the variables to split on: the relative order of the highest-degree vertices and the
+// page of the heaviest edges, alternately; variables known to the encoders are skipped
+vector<MVar> chooseSplitVars(SATModel& model, InputGraph& inputGraph, Params& params) {
+  int n = inputGraph.nc;
+  vector<int> degree(n, 0);
+  for (auto& edge : inputGraph.edges) {
+    degree[edge.first]++;
+    degree[edge.second]++;
+  }
+  vector<int> vertices(n);
+  for (int i = 0; i < n; i++) {
+    vertices[i] = i;
+  }
+  stable_sort(vertices.begin(), vertices.end(), [&](int u, int v) {
+    return degree[u] > degree[v];
+  });
+  vector<int> edges(inputGraph.edges.size());
+  for (size_t i = 0; i < edges.size(); i++) {
+    edges[i] = int(i);
+  }
+  auto weight = [&](int e) {
+    return degree[inputGraph.edges[e].first] + degree[inputGraph.edges[e].second];
+  };
+  stable_sort(edges.begin(), edges.end(), [&](int e1, int e2) {
+    return weight(e1) > weight(e2);
+  });
+
+  // the pairs of the top vertices and the (edge, page) pairs in the order of preference;
+  // the last page of an edge is implied by the others
+  vector<MVar> relCandidates;
+  for (int j = 1; j < n; j++) {
+    for (int i = 0; i < j; i++) {
+      relCandidates.push_back(model.getRelVar(vertices[i], vertices[j], true));
+    }
+    if (int(relCandidates.size()) >= 4 * params.cubeDepth) break;
+  }
+  vector<MVar> pageCandidates;
+  auto& pageBlock = model.getBlock(PAGE_VARS);
+  if (pageBlock.exists() && pageBlock.cols > 1) {
+    for (int e : edges) {
+      for (int page = 0; page + 1 < pageBlock.cols; page++) {
+        pageCandidates.push_back(model.getPageVar(e, page, true));
+      }
+      if (int(pageCandidates.size()) >= 4 * params.cubeDepth) break;
+    }
+  }
+
+  vector<MVar> res;
+  size_t nextRel = 0, nextPage = 0;
+  auto take = [&](const vector<MVar>& candidates, size_t& next) {
+    while (next < candidates.size() && model.knownValue(candidates[next]) != 0) {
+      next++;
+    }
+    if (next < candidates.size() && int(res.size()) < params.cubeDepth) {
+      res.push_back(candidates[next++]);
+    }
+  };
+  while (int(res.size()) < params.cubeDepth && (nextRel < relCandidates.size() || nextPage < pageCandidates.size())) {
+    take(relCandidates, nextRel);
+    take(pageCandidates, nextPage);
+  }
+  LOG_IF(int(res.size()) < params.cubeDepth, "only %d split variables are available", int(res.size()));
+  return res;
+}
+
+// true once the time limit of the run is exceeded; empty without a limit
+std::function<bool()> timeLimit(const Params& params) {
+  if (params.timeout <= 0) {
+    return nullptr;
+  }
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(params.timeout);
+  return [deadline]() {
+    return std::chrono::steady_clock::now() >= deadline;
+  };
+}
+
+// an unfinished solver is an error, reported with its own exit code on a timeout
+void checkFinished(SatSolver::Result res, const Params& params, const std::function<bool()>& expired) {
+  CHECK(res != SatSolver::UNKNOWN || !expired || !expired(), "time limit of " + to_string(params.timeout) + " seconds exceeded", TIMEOUT_EXIT_CODE);
+  CHECK(res != SatSolver::UNKNOWN, "the solver did not finish");
+}
+
+// whether the heuristic layout respects all constraints of the layout type
+bool heuristicApplies(const InputGraph& inputGraph, const Params& params) {
+  if (params.heuristic <= 0 || params.trees || params.adjacent || params.local > 0 || params.strict || inputGraph.numCustomConstraints() > 0 ||
+      !inputGraph.fixedPages.empty() ||
+      !inputGraph.planar_edges.empty() || !inputGraph.planar_faces.empty()) {
+    return false;
+  }
+  return params.isStack() || params.isQueue() || params.isMixed();
+}
+
+// solves the model of the graph in-process (or by a streamed external solver) and reads the
+// layout of a solution; with cube-and-conquer, the model is kept in memory and loaded into
+// every worker. A complete heuristic layout skips the solver, and an incomplete one is its
+// starting point. The solvers stop early if terminate() becomes true
+SatSolver::Result solveLayout(InputGraph& inputGraph, Params& params, const std::function<bool()>& terminate, Layout& layout) {
+  Layout hint;
+  if (heuristicApplies(inputGraph, params)) {
+    size_t unplaced = heuristicLayout(inputGraph, params, params.heuristic, hint);
+    LOG_IF(params.verbose, "heuristic layout places %zu of %zu edges", inputGraph.edges.size() - unplaced, inputGraph.edges.size());
+    if (unplaced == 0) {
+      layout = hint;
+      return SatSolver::SAT;
+    }
+  }
+
+  if (params.cubeDepth > 0) {
+    CHECK(!params.preprocess && !params.lazyTransitivity, "cube-and-conquer cannot be combined with '-preprocess' or '-lazy-transitivity'");
+    SATModel model;
+    if (!encodeModel(model, inputGraph, params, terminate)) {
+      return SatSolver::UNKNOWN;
+    }
+    auto splitVars = chooseSplitVars(model, inputGraph, params);
+
+    vector<CubeStats> stats;
+    auto res = solveCubes(model, splitVars, params, stats, terminate);
+    if (res == SatSolver::SAT) {
+      decodeLayout(inputGraph, params, model, nullptr, layout);
+    }
+    return res;
+  }
+
+  SolverRun run;
+  auto res = encodeAndSolve(inputGraph, params, run, terminate, hint.order.empty() ? nullptr : &hint);
+  if (res == SatSolver::SAT) {
+    decodeLayout(inputGraph, params, run.model, run.reconstruction(), layout);
+  }
+  return res;
+}
+
+// Solves the parts of a decomposed graph on params.threads workers, the largest parts
+// first, and merges their layouts; an infeasible part cancels the others
+SatSolver::Result solveParts(InputGraph& inputGraph, Params& params, vector<GraphPart>& parts, const std::function<bool()>& expired, Layout& layout) {
+  vector<size_t> queue(parts.size());
+  for (size_t i = 0; i < parts.size(); i++) {
+    queue[i] = i;
+  }
+  stable_sort(queue.begin(), queue.end(), [&](size_t a, size_t b) {
+    return parts[a].graph.edges.size() > parts[b].graph.edges.size();
+  });
+  LOG_IF(params.verbose, "decomposed the graph into %zu %s; the largest has %d vertices and %zu edges",
+         parts.size(), params.isStack() ? "blocks" : "components", parts[queue[0]].graph.nc, parts[queue[0]].graph.edges.size());
+
+  vector<Layout> layouts(parts.size());
+  vector<SatSolver::Result> results(parts.size(), SatSolver::UNKNOWN);
+  std::atomic<size_t> next(0);
+  std::atomic<bool> infeasible(false);
+  std::atomic<bool> failed(false);
+  auto terminate = [&infeasible, &expired]() {
+    return infeasible.load() || (expired && expired());
+  };
+
+  int workers = max(1, min(params.threads, int(parts.size())));
+  vector<std::thread> threads;
+  for (int w = 0; w < workers; w++) {
+    threads.emplace_back([&]() {
+      size_t k;
+      while (!terminate() && (k = next++) < queue.size()) {
+        size_t i = queue[k];
+        Params partParams = params;
+        partParams.verbose = params.verbose >= 2 ? params.verbose : 0;
+        try {
+          if (!checkLowerBound(parts[i].graph, partParams)) {
+            results[i] = SatSolver::UNSAT;
+          } else {
+            results[i] = solveLayout(parts[i].graph, partParams, terminate, layouts[i]);
+          }
+        } catch (...) {
+          failed = true;
+          infeasible = true;
+          return;
+        }
+        LOG_IF(params.verbose >= 2, "part %zu with %d vertices and %zu edges: %s", i, parts[i].graph.nc, parts[i].graph.edges.size(),
+               results[i] == SatSolver::SAT ? "SAT" : results[i] == SatSolver::UNSAT ? "UNSAT" : "cancelled");
+        if (results[i] == SatSolver::UNSAT) {
+          infeasible = true;
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  CHECK(!failed, "solving a part of the graph failed");
+
+  for (auto res : results) {
+    if (res == SatSolver::UNSAT) {
+      return SatSolver::UNSAT;
+    }
+  }
+  for (auto res : results) {
+    if (res != SatSolver::SAT) {
+      return SatSolver::UNKNOWN;
+    }
+  }
+  layout = mergeLayouts(inputGraph, parts, layouts, params.isTrack());
+  return SatSolver::SAT;
+}
+
+// The parts of the graph that can be laid out independently: the connected components, and
+// for stack layouts the biconnected blocks (whose layouts are rotated to a cut vertex).
+// Constraints that refer to the whole graph or to the pages at a vertex keep it in one piece
+vector<GraphPart> independentParts(const InputGraph& inputGraph, const Params& params) {
+  if (!params.decompose || params.trees || params.adjacent || params.isMixedPages() || inputGraph.numCustomConstraints() > 0 ||
+      !inputGraph.planar_edges.empty() || !inputGraph.planar_faces.empty()) {
+    return vector<GraphPart>();
+  }
+  bool blocks = params.isStack() && !params.directed && !params.dispersible && params.local == 0;
+  return decomposeGraph(inputGraph, blocks);
+}
+
+// The kernelization rules that are sound for the layout type: a leaf next to its neighbour
+// spans no vertex, so it fits on a stack page; a twin leaf copies the page (or track) of the
+// kept one, which fails for matchings and strict queues only; an ear right after its end
+// vertex is nested by the stack pages. Constraints on named vertices and edges, on the
+// structure of the pages, and on the pages at a vertex disable the rules they affect
+KernelRules kernelRules(const InputGraph& inputGraph, const Params& params) {
+  KernelRules rules;
+  if (!params.kernelize || params.trees || params.adjacent || inputGraph.numCustomConstraints() > 0 ||
+      !inputGraph.planar_edges.empty() || !inputGraph.planar_faces.empty()) {
+    rules.isolated = false;
+    return rules;
+  }
+  if (!inputGraph.fixedPages.empty()) {
+    // the removed edges are put back on page 0 or on the page of a twin
+    return rules;
+  }
+  bool stackPage = (params.isStack() || params.isMixed()) && !params.dispersible && params.local == 0;
+  rules.leaves = stackPage;
+  rules.leafTwins = !rules.leaves && !params.dispersible && !(params.strict && !params.isTrack());
+  rules.ears = stackPage && !params.directed;
+  return rules;
+}
+
+// solves the graph by its independent parts (or as a whole)
+SatSolver::Result solveGraph(InputGraph& inputGraph, Params& params, const std::function<bool()>& expired, Layout& layout) {
+  auto parts = independentParts(inputGraph, params);
+  return parts.size() > 1 ? solveParts(inputGraph, params, parts, expired, layout) : solveLayout(inputGraph, params, expired, layout);
+}
+
+bool runInternal(InputGraph& inputGraph, Params params) {
+  CHECK(!params.skipSAT);
+  auto expired = timeLimit(params);
+  if (!checkLowerBound(inputGraph, params)) {
+    return false;
+  }
+
+  if (params.resultFile != "" && params.mapFile != "") {
+    return decodeWithVarMap(inputGraph, params);
+  }
+
+  if (params.orderFile != "") {
+    Layout layout;
+    layout.order = readOrder(params.orderFile, inputGraph);
+    auto res = assignPagesForOrder(inputGraph, params, expired, layout);
+    checkFinished(res, params, expired);
+    if (res == SatSolver::UNSAT) {
+      return false;
+    }
+    printResult(inputGraph, params, layout.order, layout.pages, layout.tracks);
+    return true;
+  }
+
+  if (params.modelFile == "" && params.resultFile == "") {
+    Layout layout;
+    auto kernel = kernelize(inputGraph, kernelRules(inputGraph, params));
+    auto res = SatSolver::SAT;
+    if (kernel.removed.empty()) {
+      res = solveGraph(inputGraph, params, expired, layout);
+    } else {
+      LOG_IF(params.verbose, "kernelization removed %d vertices and %zu edges", inputGraph.nc - int(kernel.reduced.vertices.size()),
+             inputGraph.edges.size() - kernel.reduced.edges.size());
+      Layout reducedLayout;
+      if (!kernel.reduced.edges.empty()) {
+        res = solveGraph(kernel.reduced.graph, params, expired, reducedLayout);
+      }
+      if (res == SatSolver::SAT) {
+        layout = expandLayout(inputGraph, kernel, reducedLayout, params.isTrack());
+      }
+    }
+    checkFinished(res, params, expired);
+    if (res == SatSolver::UNSAT) {
+      return false;
+    }
+    printResult(inputGraph, params, layout.order, layout.pages, layout.tracks);
+    return true;
+  }
+
+  // without the sidecar, the numbering of the variables is rebuilt by encoding the model again
+  if (params.resultFile != "") {
+    LOG("no variable map is given with '-map'; the whole model is encoded again to decode the result");
+  }
+
+  SATModel model;
+
+  // clauses are streamed to the output file or, when decoding a result, only counted
+  std::unique_ptr<ClauseSink> sink;
+  if (params.modelFile != "") {
+    sink.reset(new CnfWriter(params.modelFile, params.compressionLevel, params.threads));
+  } else {
+    sink.reset(new CountingSink());
+  }
+
+  // the optional preprocessor simplifies the clauses before passing them on
+  std::unique_ptr<CnfPreprocessor> preprocessor;
+  if (params.preprocess) {
+    preprocessor.reset(new CnfPreprocessor(params.modelFile != "" ? sink.get() : nullptr, params.verbose));
+    model.setSink(preprocessor.get());
+  } else {
+    model.setSink(sink.get());
+  }
+
+  encodeModel(model, inputGraph, params);
+  if (preprocessor) {
+    freezeDecodedVars(model, *preprocessor);
+    preprocessor->finish(model.varCount(), model.clauseCount());
+  } else {
+    sink->finish(model.varCount(), model.clauseCount());
+  }
   if (params.modelFile != "") {
-    model.toDimacs(params.modelFile);
     LOG_IF(params.verbose, "SAT model in dimacs format saved to '%s'", params.modelFile.c_str());
+    if (params.mapFile != "") {
+      writeVarMap(inputGraph, params, model, preprocessor ? &preprocessor->reconstruction() : nullptr);
+      LOG_IF(params.verbose, "variable map saved to '%s'", params.mapFile.c_str());
+    }
     return true;
   } 
 
   auto externalResult = model.fromDimacs(params.resultFile);
   if (externalResult == "SATISFIABLE") {
-    CHECK(fillResult(inputGraph, params, model), "cannot construct layout from SAT assignment");
+    decodeSolution(inputGraph, params, model, preprocessor ? &preprocessor->reconstruction() : nullptr);
     return true;
   } 
 
@@ -1285,9 +2475,85 @@ bool run(InputGraph& inputGraph, Params params) {
 	bool res;
   try {
     res = runInternal(inputGraph, params);
+  } catch (int code) {
+    if (code == TIMEOUT_EXIT_CODE) throw;
+  	res = false;
+  	ERROR("exception during SAT model construction");
   } catch (...) {
   	res = false;
   	ERROR("exception during SAT model construction");
   }
   return res;
 }
+
+bool runPortfolioInternal(InputGraph& inputGraph, vector<Params>& configs) {
+  CHECK(!configs.empty());
+  if (!checkLowerBound(inputGraph, configs[0])) {
+    return false;
+  }
+
+  // every configuration encodes its own copy of the graph
+  size_t count = configs.size();
+  vector<InputGraph> graphs(count, inputGraph);
+  vector<SolverRun> runs(count);
+  vector<SatSolver::Result> results(count, SatSolver::UNKNOWN);
+  std::atomic<bool> done(false);
+  std::mutex mutex;
+  int winner = -1;
+  auto startTime = std::chrono::steady_clock::now();
+  auto expired = timeLimit(configs[0]);
+
+  vector<std::thread> threads;
+  for (size_t i = 0; i < count; i++) {
+    threads.emplace_back([&, i]() {
+      // the lines of a configuration are told apart by its index
+      logPrefix() = "[" + to_string(i) + "] ";
+      try {
+        results[i] = encodeAndSolve(graphs[i], configs[i], runs[i], [&done, &expired]() {
+          return done.load() || (expired && expired());
+        });
+      } catch (...) {
+        LOG("portfolio configuration %d [%s] failed", int(i), configs[i].name.c_str());
+        return;
+      }
+
+      if (results[i] != SatSolver::UNKNOWN) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (winner == -1) {
+          winner = int(i);
+          done = true;
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  if (winner == -1) {
+    checkFinished(SatSolver::UNKNOWN, configs[0], expired);
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+  LOG_IF(configs[winner].verbose, "portfolio configuration %d [%s] finished first after %.2lf seconds",
+         winner, configs[winner].name.c_str(), seconds);
+  if (results[winner] == SatSolver::UNSAT) {
+    return false;
+  }
+  decodeSolution(graphs[winner], configs[winner], runs[winner].model, runs[winner].reconstruction());
+  return true;
+}
+
+bool runPortfolio(InputGraph& inputGraph, vector<Params> configs) {
+  bool res;
+  try {
+    res = runPortfolioInternal(inputGraph, configs);
+  } catch (int code) {
+    if (code == TIMEOUT_EXIT_CODE) throw;
+    res = false;
+    ERROR("exception during portfolio run");
+  } catch (...) {
+    res = false;
+    ERROR("exception during portfolio run");
+  }
+  return res;
+}
@@ -30,10 +30,14 @@ struct InputGraph {
   std::map<int, int> color;
   // whether an edge is allowed to be on multiple pages
   std::vector<bool> multiPage;
+  // the page of every edge, if the page assignment is fixed (empty otherwise)
+  std::vector<int> fixedPages;
 
   // Constraints:
   // first node in the order
   int firstNode = 0;
+  // the pair of vertices that sets the direction of the spine: first < second
+  std::pair<int, int> spineDirection = std::make_pair(1, 2);
   // pair<i, j>  ==>  node_i < node_j in the order
   std::vector<std::pair<int, int>> nodeRel;
   // pair<>  ==>  the two relations between the pairs of nodes are the same
@@ -48,6 +52,11 @@ struct InputGraph {
   std::vector<std::pair<int, std::vector<int>>> groupEdgePages;
   // node ==> available tracks are in [0..pages)
   std::map<int, std::vector<int>> nodeTracks;
+  // generators of graph automorphisms (vertex v ==> gen[v]) broken by lex-leader constraints
+  std::vector<std::vector<int>> automorphisms;
+  // classes of interchangeable vertices, sorted by nodeRel constraints; their pairs come
+  // first in the order of the lex-leader constraints
+  std::vector<std::vector<int>> twins;
 
   InputGraph() {}
 
@@ -224,6 +233,26 @@ struct InputGraph {
 
 enum Embedding { STACK, QUEUE, TRACK, MIXED, MIXED_PAGES };
 
+// linking of same-page variables to page variables: p^2 clauses per pair, 2p clauses
+// per pair, or the smaller of the two; pairs with multi-page edges are always linear
+enum SamePageEncoding { SP_AUTO, SP_QUADRATIC, SP_LINEAR };
+
+// constraints of an edge pair in mixed and mixed-page layouts: the crossing (nesting)
+// patterns repeated for every stack (queue) page, or a "crosses" and a "nests" variable
+// per pair that are shared by the pages; auto shares them for 3+ mixed pages and 2+
+// mixed-page pages
+enum PatternEncoding { PATTERN_AUTO, PATTERN_DIRECT, PATTERN_SHARED };
+
+// Encodings of "at most k of the literals are true"
+//   - pairwise:   a clause per (k+1)-subset; no auxiliary variables
+//   - sequential: the sequential counter (ladder for k = 1); O(nk) clauses
+//   - commander:  groups of 3 with a commander variable each, recursively (k = 1)
+//   - binary:     the index of the true literal in log(n) bits (k = 1)
+//   - totalizer:  a tree of unary adders cut at k+1; O(nk log n) clauses
+// commander and binary are at-most-one encodings; the sequential counter is used
+// in their place for k > 1. auto picks an encoding based on n and k
+enum CardinalityEncoding { CARD_AUTO, CARD_PAIRWISE, CARD_SEQUENTIAL, CARD_COMMANDER, CARD_BINARY, CARD_TOTALIZER };
+
 struct Params {
   Embedding embedding = STACK;
 
@@ -248,19 +277,63 @@ struct Params {
   std::string custom = "";
   // strict queue layouts
   bool strict = false;
-
-  // SAT solver to use
+  // encoding of same-page variables
+  SamePageEncoding samePageEncoding = SP_AUTO;
+  // encoding of crossings and nestings in mixed and mixed-page layouts
+  PatternEncoding patternEncoding = PATTERN_AUTO;
+  // encodings of "at most one page", "at most one track" and "at most local pages"
+  CardinalityEncoding pageCardinality = CARD_AUTO;
+  CardinalityEncoding trackCardinality = CARD_AUTO;
+  CardinalityEncoding localCardinality = CARD_AUTO;
+
+  // command of an external SAT solver, which reads the CNF from stdin and prints the
+  // result in the competition format ('s' and 'v' lines) to stdout. The bundled
+  // solver is used if empty
   std::string solver;
+  // wall-clock time limit of encoding and solving in seconds (0 for none)
+  int timeout = 0;
+  // whether transitivity of the relative order is added only for the cyclic triples
+  // of the solutions, re-solving until the order is consistent
+  bool lazyTransitivity = false;
+  // the number of split variables of cube-and-conquer (0 to disable); the 2^d cubes
+  // are solved by 'threads' workers
+  int cubeDepth = 0;
   // whether to skip SAT model altogether
   bool skipSAT = false;
   // whether to skip SAT solving
   bool skipSolve = false;
   int verbose = 0;
-  // whether to apply symmetry-breaking constraints using BreakID
-  bool applyBreakID = false;
+  // whether to break the automorphisms of the graph by lex-leader constraints over the
+  // relative order (as BreakID does for the symmetries of a formula); otherwise only
+  // vertices with identical neighbourhoods are ordered
+  bool applyBreakID = true;
+  // whether to add the built-in symmetry-breaking constraints
+  bool breakSymmetry = true;
+  // random seed of the bundled solver (0 for the default behavior)
+  int seed = 0;
+  // description of the configuration in portfolio runs
+  std::string name;
+  // whether to simplify the model before writing it
+  bool preprocess = false;
   // Dimacs input/output
   std::string modelFile = "";
   std::string resultFile = "";
+  // variable map of the model (written with the model, read to decode the result)
+  std::string mapFile = "";
+  // a fixed vertex order; only the pages are assigned
+  std::string orderFile = "";
+  // gzip compression level for .gz models
+  int compressionLevel = 9;
+  // the number of worker threads
+  int threads = 1;
+  // whether the connected components (and the blocks of stack layouts) are solved separately
+  bool decompose = true;
+  // whether to remove the vertices whose layout follows from the rest (isolated vertices,
+  // leaves, ears) before encoding
+  bool kernelize = true;
+  // the number of restarts of the heuristic layout that is tried before the SAT solver
+  // and otherwise suggests the initial values of its variables (0 to disable)
+  int heuristic = 16;
 
   Params() {}
 
@@ -349,4 +422,16 @@ struct Result {
   }
 };
 
+// a layout of a graph: the vertex order, the page of every edge and the track of every
+// vertex (track layouts only)
+struct Layout {
+  std::vector<int> order;
+  std::vector<int> pages;
+  std::vector<int> tracks;
+};
+
 bool run(InputGraph& inputGraph, Params params);
+
+// solves the configurations in parallel; the first definitive answer is reported and
+// the other runs are cancelled
+bool runPortfolio(InputGraph& inputGraph, std::vector<Params> configs);
@@ -0,0 +1,405 @@
+#include "heuristic.h"
+#include "common.h"
+#include "logging.h"
+
+#include <algorithm>
+#include <climits>
+#include <deque>
+#include <queue>
+#include <set>
+
+using namespace std;
+
+namespace {
+
+// the steps of the local search per restart
+const int LOCAL_SEARCH_STEPS = 50;
+
+enum OrderStrategy { DFS_ORDER, BFS_ORDER, DEGENERACY_ORDER };
+
+// The min and max partner of the endpoints at every position, with range queries
+class PartnerTree {
+ public:
+  explicit PartnerTree(int n) {
+    while (size < n) size *= 2;
+    lo.assign(2 * size, INT_MAX);
+    hi.assign(2 * size, INT_MIN);
+  }
+
+  void add(int pos, int partner) {
+    for (int i = pos + size; i > 0; i /= 2) {
+      lo[i] = min(lo[i], partner);
+      hi[i] = max(hi[i], partner);
+    }
+  }
+
+  // the min and max partner over the positions [from, to]; (INT_MAX, INT_MIN) if empty
+  pair<int, int> query(int from, int to) const {
+    int l = INT_MAX;
+    int h = INT_MIN;
+    for (int a = from + size, b = to + size + 1; a < b; a /= 2, b /= 2) {
+      if (a & 1) {
+        l = min(l, lo[a]);
+        h = max(h, hi[a]);
+        a++;
+      }
+      if (b & 1) {
+        b--;
+        l = min(l, lo[b]);
+        h = max(h, hi[b]);
+      }
+    }
+    return make_pair(l, h);
+  }
+
+ private:
+  int size = 1;
+  vector<int> lo;
+  vector<int> hi;
+};
+
+// The edges of a page, as positions a < b in the order. A stack page stores the partner of
+// both endpoints, a queue page the right endpoint at the left one
+struct Page {
+  Page(int n, bool isQueue): isQueue(isQueue), tree(n), used(n, false) {}
+
+  bool isQueue;
+  PartnerTree tree;
+  // the positions with an edge on the page (for dispersible layouts)
+  vector<bool> used;
+
+  bool fits(int a, int b) const {
+    if (isQueue) {
+      // no edge (c, d) with c < a < b < d or with a < c < d < b
+      return tree.query(0, a - 1).second <= b && tree.query(a + 1, b - 1).first >= b;
+    }
+    // no endpoint in (a, b) whose partner is outside [a, b]
+    auto range = tree.query(a + 1, b - 1);
+    return range.first >= a && range.second <= b;
+  }
+
+  void add(int a, int b) {
+    tree.add(a, b);
+    if (!isQueue) {
+      tree.add(b, a);
+    }
+    used[a] = used[b] = true;
+  }
+};
+
+vector<int> shuffled(const vector<int>& v) {
+  vector<int> res = v;
+  Rand::shuffle(res.begin(), res.end());
+  return res;
+}
+
+// the vertices in the order of a traversal that visits the neighbours in a random order
+vector<int> traversalOrder(const vector<vector<int>>& adj, OrderStrategy strategy) {
+  int n = int(adj.size());
+  vector<int> order;
+  vector<bool> visited(n, false);
+
+  if (strategy == DEGENERACY_ORDER) {
+    // the smallest-last order: the vertex of the smallest remaining degree is removed
+    // until none is left, and the order is the reverse of the removal
+    vector<int> key = Rand::permutation(n);
+    vector<int> degree(n);
+    set<pair<int, int>> remaining;
+    for (int v = 0; v < n; v++) {
+      degree[v] = int(adj[v].size());
+      remaining.insert(make_pair(degree[v], key[v]));
+    }
+    vector<int> vertexOf(n);
+    for (int v = 0; v < n; v++) {
+      vertexOf[key[v]] = v;
+    }
+    while (!remaining.empty()) {
+      int v = vertexOf[remaining.begin()->second];
+      remaining.erase(remaining.begin());
+      visited[v] = true;
+      order.push_back(v);
+      for (int u : adj[v]) {
+        if (visited[u]) continue;
+        remaining.erase(make_pair(degree[u], key[u]));
+        degree[u]--;
+        remaining.insert(make_pair(degree[u], key[u]));
+      }
+    }
+    reverse(order.begin(), order.end());
+    return order;
+  }
+
+  // a component starts at a vertex of the smallest degree, like the corner of a grid
+  vector<int> roots = Rand::permutation(n);
+  stable_sort(roots.begin(), roots.end(), [&](int u, int v) {
+    return adj[u].size() < adj[v].size();
+  });
+  bool smallestFirst = Rand::check(0.5);
+  for (int root : roots) {
+    if (visited[root]) continue;
+    // a stack of discovered vertices gives a DFS, a queue a BFS
+    deque<int> pending;
+    pending.push_back(root);
+    if (strategy == BFS_ORDER) {
+      visited[root] = true;
+    }
+    while (!pending.empty()) {
+      int v;
+      if (strategy == DFS_ORDER) {
+        v = pending.back();
+        pending.pop_back();
+        if (visited[v]) continue;
+        visited[v] = true;
+      } else {
+        v = pending.front();
+        pending.pop_front();
+      }
+      order.push_back(v);
+      // every other DFS continues at a neighbour of the smallest degree, which follows
+      // the boundary of outerplanar graphs
+      vector<int> next = shuffled(adj[v]);
+      if (strategy == DFS_ORDER && smallestFirst) {
+        stable_sort(next.begin(), next.end(), [&](int a, int b) {
+          return adj[a].size() > adj[b].size();
+        });
+      }
+      for (int u : next) {
+        if (visited[u]) continue;
+        if (strategy == BFS_ORDER) {
+          visited[u] = true;
+        }
+        pending.push_back(u);
+      }
+    }
+  }
+  return order;
+}
+
+// a topological order of the arcs that takes the vertices in the given order whenever
+// possible; shorter than n if the arcs have a cycle
+vector<int> topologicalOrder(const InputGraph& inputGraph, const vector<int>& preferred) {
+  int n = inputGraph.nc;
+  vector<int> rank(n);
+  for (int i = 0; i < n; i++) {
+    rank[preferred[i]] = i;
+  }
+  vector<vector<int>> out(n);
+  vector<int> inDegree(n, 0);
+  for (auto& arc : inputGraph.directedEdges()) {
+    out[arc.first].push_back(arc.second);
+    inDegree[arc.second]++;
+  }
+
+  priority_queue<pair<int, int>, vector<pair<int, int>>, greater<pair<int, int>>> ready;
+  for (int v = 0; v < n; v++) {
+    if (inDegree[v] == 0) {
+      ready.push(make_pair(rank[v], v));
+    }
+  }
+  vector<int> order;
+  while (!ready.empty()) {
+    int v = ready.top().second;
+    ready.pop();
+    order.push_back(v);
+    for (int u : out[v]) {
+      if (--inDegree[u] == 0) {
+        ready.push(make_pair(rank[u], u));
+      }
+    }
+  }
+  return order;
+}
+
+// whether two edges, as positions a < b, cannot share a stack (queue) page
+bool conflicting(pair<int, int> e1, pair<int, int> e2, bool isQueue, bool dispersible) {
+  int a = e1.first, b = e1.second, c = e2.first, d = e2.second;
+  if (dispersible && (a == c || a == d || b == c || b == d)) {
+    return true;
+  }
+  if (isQueue) {
+    return (a < c && d < b) || (c < a && b < d);
+  }
+  return (a < c && c < b && b < d) || (c < a && a < d && d < b);
+}
+
+// places the unplaced edges that conflict with a single edge of a page, which moves to a
+// page where it fits; returns the number of edges that stay unplaced
+size_t repairPages(const InputGraph& inputGraph, const Params& params, const vector<int>& pos, vector<int>& edgePages) {
+  int numPages = params.stacks + params.queues;
+  auto positions = [&](int e) {
+    int a = pos[inputGraph.edges[e].first];
+    int b = pos[inputGraph.edges[e].second];
+    return make_pair(min(a, b), max(a, b));
+  };
+  // the edges that conflict with e on the page, stopping after the limit
+  vector<vector<int>> onPage(numPages);
+  for (size_t e = 0; e < edgePages.size(); e++) {
+    if (edgePages[e] != -1) {
+      onPage[edgePages[e]].push_back(int(e));
+    }
+  }
+  auto conflicts = [&](int e, int page, size_t limit) {
+    vector<int> res;
+    for (int f : onPage[page]) {
+      if (f != e && conflicting(positions(e), positions(f), page >= params.stacks, params.dispersible)) {
+        res.push_back(f);
+        if (res.size() >= limit) break;
+      }
+    }
+    return res;
+  };
+
+  size_t unplaced = 0;
+  for (size_t e = 0; e < edgePages.size(); e++) {
+    if (edgePages[e] != -1) continue;
+    for (int p = 0; p < numPages && edgePages[e] == -1; p++) {
+      auto blocking = conflicts(int(e), p, 2);
+      if (blocking.size() != 1) continue;
+      int f = blocking[0];
+      for (int q = 0; q < numPages; q++) {
+        if (q == p || !conflicts(f, q, 1).empty()) continue;
+        onPage[p].erase(find(onPage[p].begin(), onPage[p].end(), f));
+        onPage[q].push_back(f);
+        edgePages[f] = q;
+        onPage[p].push_back(int(e));
+        edgePages[e] = p;
+        break;
+      }
+    }
+    if (edgePages[e] == -1) {
+      unplaced++;
+    }
+  }
+  return unplaced;
+}
+
+// assigns the edges first-fit, the longest first (ties broken randomly), and repairs the
+// rest; returns the number of edges that fit on no page
+size_t assignPages(const InputGraph& inputGraph, const Params& params, const vector<int>& order, vector<int>& edgePages) {
+  int n = inputGraph.nc;
+  size_t m = inputGraph.edges.size();
+  vector<int> pos(n);
+  for (int i = 0; i < n; i++) {
+    pos[order[i]] = i;
+  }
+  auto span = [&](int e) {
+    return abs(pos[inputGraph.edges[e].first] - pos[inputGraph.edges[e].second]);
+  };
+  vector<int> key = Rand::permutation(m);
+  vector<int> edges(m);
+  for (size_t e = 0; e < m; e++) {
+    edges[e] = int(e);
+  }
+  sort(edges.begin(), edges.end(), [&](int e1, int e2) {
+    return make_pair(-span(e1), key[e1]) < make_pair(-span(e2), key[e2]);
+  });
+
+  // pages [0, stacks) are stacks and the rest are queues
+  vector<Page> pages;
+  for (int p = 0; p < params.stacks + params.queues; p++) {
+    pages.push_back(Page(n, p >= params.stacks));
+  }
+  edgePages.assign(m, -1);
+  size_t unplaced = 0;
+  for (int e : edges) {
+    int a = pos[inputGraph.edges[e].first];
+    int b = pos[inputGraph.edges[e].second];
+    if (a > b) swap(a, b);
+    for (size_t p = 0; p < pages.size() && edgePages[e] == -1; p++) {
+      if (params.dispersible && (pages[p].used[a] || pages[p].used[b])) continue;
+      if (pages[p].fits(a, b)) {
+        pages[p].add(a, b);
+        edgePages[e] = int(p);
+      }
+    }
+    if (edgePages[e] == -1) {
+      unplaced++;
+    }
+  }
+  return unplaced == 0 ? 0 : repairPages(inputGraph, params, pos, edgePages);
+}
+
+// whether every arc points forward in the order
+bool isForward(const InputGraph& inputGraph, const vector<int>& order) {
+  vector<int> pos(order.size());
+  for (size_t i = 0; i < order.size(); i++) {
+    pos[order[i]] = int(i);
+  }
+  for (auto& arc : inputGraph.directedEdges()) {
+    if (pos[arc.first] > pos[arc.second]) return false;
+  }
+  return true;
+}
+
+// A local search over the order: an endpoint of a random unplaced edge moves next to a
+// random neighbour, which is kept unless fewer edges are placed; returns the number of
+// unplaced edges of the final layout
+size_t improveLayout(const InputGraph& inputGraph, const Params& params, const vector<vector<int>>& adj, int steps, Layout& layout, size_t unplaced) {
+  for (int step = 0; step < steps && unplaced > 0; step++) {
+    vector<int> open;
+    for (size_t e = 0; e < layout.pages.size(); e++) {
+      if (layout.pages[e] == -1) {
+        open.push_back(int(e));
+      }
+    }
+    auto& edge = inputGraph.edges[open[Rand::next(int(open.size()))]];
+    int w = Rand::check(0.5) ? edge.first : edge.second;
+    int x = adj[w][Rand::next(int(adj[w].size()))];
+
+    Layout candidate;
+    candidate.order = layout.order;
+    candidate.order.erase(find(candidate.order.begin(), candidate.order.end(), w));
+    auto it = find(candidate.order.begin(), candidate.order.end(), x);
+    candidate.order.insert(Rand::check(0.5) ? it : it + 1, w);
+    if (params.directed && !isForward(inputGraph, candidate.order)) continue;
+
+    size_t res = assignPages(inputGraph, params, candidate.order, candidate.pages);
+    if (res <= unplaced) {
+      unplaced = res;
+      layout = candidate;
+    }
+  }
+  return unplaced;
+}
+
+}
+
+size_t heuristicLayout(const InputGraph& inputGraph, const Params& params, int restarts, Layout& layout) {
+  CHECK(params.isStack() || params.isQueue() || params.isMixed(), "the heuristic supports stack, queue and mixed layouts");
+  int n = inputGraph.nc;
+  size_t m = inputGraph.edges.size();
+  vector<vector<int>> adj(n);
+  for (auto& edge : inputGraph.edges) {
+    adj[edge.first].push_back(edge.second);
+    adj[edge.second].push_back(edge.first);
+  }
+
+  // DFS orders suit stacks and BFS orders suit queues
+  OrderStrategy strategies[] = {DFS_ORDER, DEGENERACY_ORDER, BFS_ORDER};
+  if (params.isQueue()) {
+    swap(strategies[0], strategies[2]);
+  }
+
+  Rand::setSeed(size_t(params.seed));
+  size_t best = m + 1;
+  for (int r = 0; r < restarts && best > 0; r++) {
+    vector<int> order = traversalOrder(adj, strategies[r % 3]);
+    if (params.directed) {
+      order = topologicalOrder(inputGraph, order);
+      if (int(order.size()) < n) {
+        // the arcs have a cycle
+        layout = Layout();
+        return m;
+      }
+    }
+
+    Layout candidate;
+    candidate.order = order;
+    size_t unplaced = assignPages(inputGraph, params, order, candidate.pages);
+    if (unplaced < best) {
+      best = unplaced;
+      layout = candidate;
+    }
+  }
+  return improveLayout(inputGraph, params, adj, LOCAL_SEARCH_STEPS * restarts, layout, best);
+}
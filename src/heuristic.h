@@ -0,0 +1,16 @@
+#pragma once
+
+#include "glucoseMain.h"
+
+#include <cstddef>
+
+// A layout found without the SAT solver. The vertex order comes from a DFS, BFS or
+// degeneracy (smallest-last) traversal with randomized tie-breaking by Rand; directed
+// graphs take a topological order that follows the traversal. The edges are coloured
+// first-fit, the longest first: an edge takes the first page on which it crosses (nests)
+// no edge of a stack (queue) page, which segment trees over the positions decide in
+// O(log n); dispersible pages are matchings. The best of the restarts is improved by a
+// local search that moves the endpoints of unplaced edges next to their neighbours.
+// Returns the number of edges that fit on none of the pages (with page -1); the search
+// stops at the first complete layout
+size_t heuristicLayout(const InputGraph& inputGraph, const Params& params, int restarts, Layout& layout);
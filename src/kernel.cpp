@@ -0,0 +1,261 @@
+#include "kernel.h"
+#include "logging.h"
+
+#include <deque>
+
+using namespace std;
+
+namespace {
+
+class Reduction {
+ public:
+  Reduction(const InputGraph& inputGraph, const KernelRules& rules)
+      : inputGraph(inputGraph), rules(rules), n(inputGraph.nc), adj(n), degree(n, 0),
+        removedVertex(n, false), removedEdge(inputGraph.edges.size(), false), checkedEar(n, false), keptLeaf(2 * n, -1) {
+    for (size_t i = 0; i < inputGraph.edges.size(); i++) {
+      auto& edge = inputGraph.edges[i];
+      adj[edge.first].push_back(make_pair(edge.second, int(i)));
+      adj[edge.second].push_back(make_pair(edge.first, int(i)));
+      degree[edge.first]++;
+      degree[edge.second]++;
+    }
+  }
+
+  Kernel run() {
+    Kernel kernel;
+    for (int v = 0; v < n; v++) {
+      queue.push_back(v);
+    }
+    while (!queue.empty()) {
+      int v = queue.front();
+      queue.pop_front();
+      if (removedVertex[v]) continue;
+
+      if (degree[v] == 0 && rules.isolated) {
+        RemovedVertices r;
+        r.rule = RemovedVertices::ISOLATED;
+        r.vertices.push_back(v);
+        removedVertex[v] = true;
+        kernel.removed.push_back(r);
+      } else if (degree[v] == 1 && (rules.leaves || rules.leafTwins)) {
+        removeLeaf(v, kernel);
+      } else if (degree[v] == 2 && rules.ears && !checkedEar[v]) {
+        removeEar(v, kernel);
+      }
+    }
+
+    vector<int> edges;
+    for (size_t i = 0; i < inputGraph.edges.size(); i++) {
+      if (!removedEdge[i]) {
+        edges.push_back(int(i));
+      }
+    }
+    if (!edges.empty()) {
+      kernel.reduced = extractPart(inputGraph, edges);
+    }
+    return kernel;
+  }
+
+ private:
+  const InputGraph& inputGraph;
+  const KernelRules& rules;
+  int n;
+  vector<vector<pair<int, int>>> adj;
+  vector<int> degree;
+  vector<bool> removedVertex;
+  vector<bool> removedEdge;
+  // whether the vertex is on a degree-2 path that is not an ear
+  vector<bool> checkedEar;
+  // a leaf at the vertex with an edge from (2v) or to (2v + 1) the vertex
+  vector<int> keptLeaf;
+  deque<int> queue;
+
+  // the edges of the vertex that are not removed
+  vector<pair<int, int>> liveEdges(int v) const {
+    vector<pair<int, int>> res;
+    for (auto& pr : adj[v]) {
+      if (!removedEdge[pr.second]) {
+        res.push_back(pr);
+      }
+    }
+    return res;
+  }
+
+  // whether the edge is directed from v to its other end
+  bool directedFrom(int e, int v) const {
+    if (inputGraph.direction.size() != inputGraph.edges.size()) return false;
+    return (inputGraph.edges[e].first == v) == bool(inputGraph.direction[e]);
+  }
+
+  void removeEdge(int e) {
+    removedEdge[e] = true;
+    for (int v : {inputGraph.edges[e].first, inputGraph.edges[e].second}) {
+      degree[v]--;
+      checkedEar[v] = false;
+      queue.push_back(v);
+    }
+  }
+
+  void removeLeaf(int v, Kernel& kernel) {
+    auto edge = liveEdges(v)[0];
+    int u = edge.first;
+    int e = edge.second;
+
+    RemovedVertices r;
+    r.vertices.push_back(v);
+    r.edges.push_back(e);
+    if (rules.leaves) {
+      r.rule = RemovedVertices::LEAF;
+      r.anchor = u;
+      r.before = directedFrom(e, v);
+    } else {
+      // keep the first leaf of every direction at u
+      int& kept = keptLeaf[2 * u + (directedFrom(e, v) ? 1 : 0)];
+      if (kept == -1 || kept == v || removedVertex[kept] || degree[kept] != 1) {
+        kept = v;
+        return;
+      }
+      r.rule = RemovedVertices::LEAF_TWIN;
+      r.anchor = kept;
+      r.twinEdge = liveEdges(kept)[0].second;
+    }
+    removedVertex[v] = true;
+    removeEdge(e);
+    kernel.removed.push_back(r);
+  }
+
+  // the path of degree-2 vertices that starts with the edge from v; the end is the first
+  // vertex of another degree, or v itself on a cycle
+  int walk(int v, pair<int, int> edge, vector<int>& vertices, vector<int>& edges) const {
+    int prevEdge = edge.second;
+    int cur = edge.first;
+    edges.push_back(prevEdge);
+    while (cur != v && degree[cur] == 2) {
+      vertices.push_back(cur);
+      for (auto& pr : liveEdges(cur)) {
+        if (pr.second != prevEdge) {
+          prevEdge = pr.second;
+          cur = pr.first;
+          break;
+        }
+      }
+      edges.push_back(prevEdge);
+    }
+    return cur;
+  }
+
+  void removeEar(int v, Kernel& kernel) {
+    auto edges = liveEdges(v);
+    vector<int> pathA, edgesA, pathB, edgesB;
+    int endA = walk(v, edges[0], pathA, edgesA);
+
+    RemovedVertices r;
+    r.rule = RemovedVertices::EAR;
+    if (endA == v) {
+      // a cycle: v is the anchor of the rest
+      r.anchor = v;
+      r.vertices = pathA;
+      r.edges = edgesA;
+    } else {
+      int endB = walk(v, edges[1], pathB, edgesB);
+      if (endA != endB) {
+        checkedEar[v] = true;
+        for (int u : pathA) checkedEar[u] = true;
+        for (int u : pathB) checkedEar[u] = true;
+        return;
+      }
+      // the path from endA through v back to endA
+      r.anchor = endA;
+      r.vertices.assign(pathA.rbegin(), pathA.rend());
+      r.vertices.push_back(v);
+      r.vertices.insert(r.vertices.end(), pathB.begin(), pathB.end());
+      r.edges.assign(edgesA.rbegin(), edgesA.rend());
+      r.edges.insert(r.edges.end(), edgesB.begin(), edgesB.end());
+    }
+
+    for (int u : r.vertices) {
+      removedVertex[u] = true;
+    }
+    for (int e : r.edges) {
+      removeEdge(e);
+    }
+    kernel.removed.push_back(r);
+  }
+};
+
+}
+
+Kernel kernelize(const InputGraph& inputGraph, const KernelRules& rules) {
+  Reduction reduction(inputGraph, rules);
+  return reduction.run();
+}
+
+Layout expandLayout(const InputGraph& inputGraph, const Kernel& kernel, const Layout& reducedLayout, bool isTrack) {
+  int n = inputGraph.nc;
+  Layout layout;
+  layout.pages.assign(inputGraph.edges.size(), -1);
+  if (isTrack) {
+    layout.tracks.assign(n, 0);
+  }
+
+  // the order is a doubly linked list of the vertices
+  vector<int> prev(n, -1);
+  vector<int> next(n, -1);
+  int head = -1;
+  int tail = -1;
+  auto insertAfter = [&](int v, int u) {
+    prev[v] = u;
+    next[v] = u == -1 ? head : next[u];
+    (next[v] == -1 ? tail : prev[next[v]]) = v;
+    (u == -1 ? head : next[u]) = v;
+  };
+
+  auto& reduced = kernel.reduced;
+  for (int v : reducedLayout.order) {
+    insertAfter(reduced.vertices[v], tail);
+  }
+  for (size_t e = 0; e < reduced.edges.size() && e < reducedLayout.pages.size(); e++) {
+    layout.pages[reduced.edges[e]] = reducedLayout.pages[e];
+  }
+  for (size_t v = 0; isTrack && v < reduced.vertices.size(); v++) {
+    layout.tracks[reduced.vertices[v]] = reducedLayout.tracks[v];
+  }
+
+  for (size_t i = kernel.removed.size(); i-- > 0;) {
+    auto& r = kernel.removed[i];
+    int v = r.vertices[0];
+    switch (r.rule) {
+      case RemovedVertices::ISOLATED:
+        insertAfter(v, tail);
+        break;
+      case RemovedVertices::LEAF:
+        insertAfter(v, r.before ? prev[r.anchor] : r.anchor);
+        layout.pages[r.edges[0]] = 0;
+        break;
+      case RemovedVertices::LEAF_TWIN:
+        insertAfter(v, r.anchor);
+        layout.pages[r.edges[0]] = layout.pages[r.twinEdge];
+        if (isTrack) {
+          layout.tracks[v] = layout.tracks[r.anchor];
+        }
+        break;
+      case RemovedVertices::EAR: {
+        int u = r.anchor;
+        for (int w : r.vertices) {
+          insertAfter(w, u);
+          u = w;
+        }
+        for (int e : r.edges) {
+          layout.pages[e] = 0;
+        }
+        break;
+      }
+    }
+  }
+
+  for (int v = head; v != -1; v = next[v]) {
+    layout.order.push_back(v);
+  }
+  CHECK(int(layout.order.size()) == n, "incorrect expansion of the layout");
+  return layout;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "decomposition.h"
+
+#include <vector>
+
+// The reduction rules of the kernelization. A rule is sound for a layout type if every
+// layout of the reduced graph extends to a layout of the input, so the caller enables it
+// only for the layout types (and constraints) where this holds
+struct KernelRules {
+  // vertices without edges (placed last, on track 0)
+  bool isolated = true;
+  // vertices of degree 1, repeatedly, so pendant trees vanish; a leaf is placed next to
+  // its neighbour, and its edge spans no vertex (any stack page)
+  bool leaves = false;
+  // all but one of the leaves at a vertex with the same edge direction; a removed leaf is
+  // placed right after the kept one, on its page and track, and its edge crosses and
+  // nests exactly the edges that the edge of the kept leaf does
+  bool leafTwins = false;
+  // paths of degree-2 vertices from a vertex back to itself (and cycles); the path is
+  // placed right after its end vertex, and its edges nest within each other only
+  bool ears = false;
+};
+
+// vertices removed by a rule, and how they are put back into a layout
+struct RemovedVertices {
+  enum Rule { ISOLATED, LEAF, LEAF_TWIN, EAR };
+
+  Rule rule;
+  // the vertices; for an ear in the order of its path from the anchor
+  std::vector<int> vertices;
+  // the neighbour of a leaf, the kept twin of a leaf twin, or the end vertex of an ear
+  int anchor = -1;
+  // the edges; for an ear in the order of its path from the anchor
+  std::vector<int> edges;
+  // the edge of the kept twin
+  int twinEdge = -1;
+  // whether a leaf is placed in front of its neighbour (an edge directed to the neighbour)
+  bool before = false;
+};
+
+struct Kernel {
+  // the graph without the removed vertices; has no edges if everything is removed
+  GraphPart reduced;
+  // in the order of the removal
+  std::vector<RemovedVertices> removed;
+};
+
+// Applies the rules until none is applicable
+Kernel kernelize(const InputGraph& inputGraph, const KernelRules& rules);
+
+// Extends a layout of the reduced graph to the input by putting the removed vertices back
+// in the reverse order of the removal
+Layout expandLayout(const InputGraph& inputGraph, const Kernel& kernel, const Layout& reducedLayout, bool isTrack);
@@ -5,6 +5,7 @@
 #include <chrono>
 #include <ctime>
 #include <cstdarg>
+#include <mutex>
 #include <unordered_map>
 
 // assertion (wild server error)
@@ -13,6 +14,8 @@ const int ERROR_EXIT_CODE = 99;
 const int CHECK_EXIT_CODE = 40;
 // user validation
 const int VERIFICATION_EXIT_CODE = 10;
+// time limit exceeded (as reported by timeout(1))
+const int TIMEOUT_EXIT_CODE = 124;
 
 #define stringize(s) #s
 #define XSTR(s) stringize(s)
@@ -37,6 +40,12 @@ const int VERIFICATION_EXIT_CODE = 10;
   }
 #define VERIFY(condition, message) \
   CHECK3(condition, message, VERIFICATION_EXIT_CODE)
+// internal consistency checks, enabled only in debug builds
+#ifdef DEBUG
+#define DCHECK(...) CHECK(__VA_ARGS__)
+#else
+#define DCHECK(...) {}
+#endif
 
 enum class TextColor {
   none,
@@ -44,7 +53,20 @@ enum class TextColor {
   blue
 };
 
+// serializes the lines logged by concurrent threads
+inline std::mutex& logMutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+// prepended to the lines logged by the current thread, e.g. the configuration of a portfolio run
+inline std::string& logPrefix() {
+  thread_local std::string prefix;
+  return prefix;
+}
+
 inline void LOG(TextColor color, const char* message, va_list args) {
+  std::lock_guard<std::mutex> lock(logMutex());
   auto end = std::chrono::system_clock::now();
   auto time = std::chrono::system_clock::to_time_t(end);
   auto stime = std::string(std::ctime(&time));
@@ -53,17 +75,17 @@ inline void LOG(TextColor color, const char* message, va_list args) {
   char* buffer = new char[16384];
   setlocale(LC_NUMERIC, "");
   std::vsprintf(buffer, message, args);
-  std::cerr << stime << " ";
+  std::string line = stime + " " + logPrefix();
 
   switch (color) {
-    case TextColor::none: std::cerr << std::string(buffer); break;
+    case TextColor::none: line += std::string(buffer); break;
 
-    case TextColor::red : std::cerr << "\033[91m" << std::string(buffer) << "\033[0m"; break;
+    case TextColor::red : line += "\033[91m" + std::string(buffer) + "\033[0m"; break;
 
-    case TextColor::blue: std::cerr << "\e[38;5;12m" << std::string(buffer) << "\e[0m"; break;
+    case TextColor::blue: line += "\e[38;5;12m" + std::string(buffer) + "\e[0m"; break;
   };
 
-  std::cerr << "\n";
+  std::cerr << line + "\n";
   delete[] buffer;
   // for (int i = 0; i < 255; i++) {
   //   string label = "ABC012";
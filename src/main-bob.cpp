@@ -1,19 +1,29 @@
 #include "logging.h"
 #include "glucoseMain.h"
+#include "cardinality.h"
 #include "cmd_options.h"
 #include "io_graph.h"
 #include "graph_parser.h"
+#include "dimacs_io.h"
+
+#include <algorithm>
+#include <csignal>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <thread>
 
 using namespace std;
 
-void prepareCMDOptions(int argc, char** argv, CMDOptions& args) {
+void defineCMDOptions(CMDOptions& args) {
 	string msg;
 	msg += "Usage: bob [options]\n";
 	args.SetUsageMessage(msg);
 
 	args.AddAllowedOption("-i", "", "Input file name (stdin, if no input file is supplied)");
-  args.AddAllowedOption("-o", "", "Output file name (stdout, if no output file is supplied)");
+  args.AddAllowedOption("-o", "", "Output file for the SAT model (without '-o' and '-result', the model is solved in-process)");
   args.AddAllowedOption("-result", "", "Resulting assignment in Dimacs format");
+  args.AddAllowedOption("-map", "", "Variable map of the model (written with '-o', '<output>.map' by default; read with '-result')");
 
   args.AddAllowedOption("-stacks", "0", "The number of stacks to use");
   args.AddAllowedOption("-queues", "0", "The number of queues to use");
@@ -23,48 +33,92 @@ void prepareCMDOptions(int argc, char** argv, CMDOptions& args) {
 	args.AddAllowedOption("-dispersible", "false", "Whether every page is a matching");
 	args.AddAllowedOption("-directed", "false", "Whether the input graph is directed");
 
+  args.AddAllowedOption("-sp-encoding", "auto", "Encoding of same-page variables: quadratic, linear or auto (linear for 3+ pages)");
+  args.AddAllowedValue("-sp-encoding", "auto");
+  args.AddAllowedValue("-sp-encoding", "quadratic");
+  args.AddAllowedValue("-sp-encoding", "linear");
+  args.AddAllowedOption("-pattern-encoding", "auto", "Crossings and nestings of mixed layouts: direct, shared or auto (shared for 3+ pages)");
+  args.AddAllowedValue("-pattern-encoding", "auto");
+  args.AddAllowedValue("-pattern-encoding", "direct");
+  args.AddAllowedValue("-pattern-encoding", "shared");
+  args.AddAllowedOption("-local", "0", "Every vertex has its adjacent edges on at most the given number of pages (0 to disable)");
+  args.AddAllowedOption("-page-amo", "auto", "Encoding of 'at most one page per edge': pairwise, sequential, commander, binary, totalizer or auto");
+  args.AddAllowedOption("-track-amo", "auto", "Encoding of 'at most one track per vertex': pairwise, sequential, commander, binary, totalizer or auto");
+  args.AddAllowedOption("-local-card", "auto", "Encoding of 'at most local pages per vertex': pairwise, sequential, totalizer or auto");
+  for (string option : {"-page-amo", "-track-amo", "-local-card"}) {
+    for (auto& name : cardinalityEncodingNames()) {
+      args.AddAllowedValue(option, name);
+    }
+  }
+  args.AddAllowedOption("-solver", "", "External SAT solver command, reading the CNF from stdin and printing the result to stdout (the bundled solver is used by default)");
+  args.AddAllowedOption("-timeout", "0", "Wall-clock time limit of encoding and solving in seconds (0 for none)");
+  args.AddAllowedOption("-lazy-transitivity", "false", "Add transitivity clauses only for the cyclic triples of the solutions");
+  args.AddAllowedOption("-preprocess", "false", "Simplify the model (unit propagation, subsumption, variable elimination) before writing it");
+
+  args.AddAllowedOption("-compression", "9", "Compression level [1..9] for gzip-compressed models");
+  args.AddAllowedOption("-threads", "0", "The number of worker threads (0 to use all available cores)");
+
+  args.AddAllowedOption("-convert", "", "Convert the given CNF file to the format of '-o' (chosen by its extension)");
+
+  args.AddAllowedOption("-symmetry", "true", "Whether to add symmetry-breaking constraints");
+  args.AddAllowedOption("-automorphisms", "true", "Whether to break the automorphisms of the graph by lex-leader constraints (otherwise only twin vertices are ordered)");
+  args.AddAllowedOption("-seed", "0", "Random seed of the bundled solver (0 for the default behavior)");
+  args.AddAllowedOption("-portfolio", "0", "The number of solver configurations to race in parallel (0 to disable)");
+  args.AddAllowedOption("-portfolio-file", "", "Portfolio configurations, one line of options per configuration ('#' starts a comment)");
+
+  args.AddAllowedOption("-decompose", "true", "Whether to solve the connected components (and the blocks of stack layouts) separately");
+  args.AddAllowedOption("-kernelize", "true", "Whether to remove the vertices whose placement follows from the rest of the layout before encoding");
+  args.AddAllowedOption("-heuristic", "16", "Restarts of the heuristic layout that is tried before the SAT solver (0 to disable)");
+  args.AddAllowedOption("-order", "", "A fixed vertex order (the vertex labels separated by whitespace); only the pages of the edges are assigned");
+  args.AddAllowedOption("-pages", "", "A fixed page of every edge, one '<u> <v> <page>' line per edge ('#' starts a comment); only the vertex order is searched");
+  args.AddAllowedOption("-cubes", "0", "Cube-and-conquer with 2^d cubes solved by '-threads' workers (0 to disable)");
+
   args.AddAllowedOption("-verbose", "0", "Verbose debug output");
+}
 
+void prepareCMDOptions(int argc, char** argv, CMDOptions& args) {
+  defineCMDOptions(args);
 	args.Parse(argc, argv);
 }
 
-void process(const CMDOptions& options) {
-	// input
-	IOGraph graph;
-	GraphParser parser;
-	if (!parser.readGraph(options.getOption("-i"), graph)) {
-		string file = options.getOption("-i");
-		if (file.length() == 0) file = "stdin";
-		ERROR("cannot parse input graph from '" + file + "'");
-	}
-
-  // create graph
-  InputGraph inputGraph;
-  inputGraph.nc = (int)graph.nodes.size();
-  for (int i = 0; i < inputGraph.nc; i++) {
-    inputGraph.id2label[i] = graph.nodes[i].id;
-    inputGraph.label2id[graph.nodes[i].id] = i;
+// Rewrites a CNF file in another format (text/binary, plain/gzip)
+void convertCnf(const CMDOptions& options) {
+  string outFile = options.getOption("-o");
+  CHECK(outFile != "", "output file for '-convert' is not provided");
+  int threads = options.getInt("-threads");
+  if (threads <= 0) {
+    threads = max(int(std::thread::hardware_concurrency()), 1);
   }
-  for (size_t i = 0; i < graph.edges.size(); i++) {
-  	auto s = graph.getNode(graph.edges[i].source);
-  	auto t = graph.getNode(graph.edges[i].target);
-  	CHECK(s->index != t->index, "Self-edges are not supported");
 
-  	if (s->index < t->index) {
-	    inputGraph.edges.push_back(make_pair(s->index, t->index));
-	    inputGraph.direction.push_back(true);
-	  } else {
-	    inputGraph.edges.push_back(make_pair(t->index, s->index));
-	    inputGraph.direction.push_back(false);
-	  }
+  CnfWriter writer(outFile, options.getInt("-compression"), threads);
+  int varCount = readCnf(options.getOption("-convert"), writer);
+  if (options.getInt("-verbose")) {
+    LOG("converted CNF with %d variables to '%s'", varCount, outFile.c_str());
   }
+}
+
+// configurations raced when no portfolio file is given
+const vector<string> DEFAULT_PORTFOLIO = {
+  "",
+  "-sp-encoding=linear -page-amo=sequential -track-amo=sequential",
+  "-symmetry=false",
+  "-lazy-transitivity",
+  "-sp-encoding=quadratic -page-amo=commander -track-amo=commander",
+  "-preprocess",
+};
 
-  // prepare params
+Params buildParams(const CMDOptions& options) {
   Params params;
  	params.trees = options.getBool("-trees");
   params.dispersible = options.getBool("-dispersible");
   params.directed = options.getBool("-directed");
   params.verbose = options.getInt("-verbose");
+  params.breakSymmetry = options.getBool("-symmetry");
+  params.applyBreakID = options.getBool("-automorphisms");
+  params.decompose = options.getBool("-decompose");
+  params.kernelize = options.getBool("-kernelize");
+  params.heuristic = options.getInt("-heuristic");
+  params.seed = options.getInt("-seed");
   params.stacks = options.getInt("-stacks");
   params.queues = options.getInt("-queues");
   params.tracks = options.getInt("-tracks");
@@ -84,11 +138,196 @@ void process(const CMDOptions& options) {
     ERROR("unknown type of layout");
   }
 
+  string spEncoding = options.getStr("-sp-encoding");
+  params.samePageEncoding = spEncoding == "linear" ? SP_LINEAR : spEncoding == "quadratic" ? SP_QUADRATIC : SP_AUTO;
+  string patternEncoding = options.getStr("-pattern-encoding");
+  params.patternEncoding = patternEncoding == "direct" ? PATTERN_DIRECT : patternEncoding == "shared" ? PATTERN_SHARED : PATTERN_AUTO;
+  params.pageCardinality = parseCardinalityEncoding(options.getStr("-page-amo"));
+  params.trackCardinality = parseCardinalityEncoding(options.getStr("-track-amo"));
+  params.localCardinality = parseCardinalityEncoding(options.getStr("-local-card"));
+  params.local = options.getInt("-local");
+  CHECK(params.local == 0 || params.embedding != TRACK, "local pages are not supported for track layouts");
+  CHECK(params.local <= params.stacks + params.queues, "local pages cannot exceed the number of pages");
+  params.preprocess = options.getBool("-preprocess");
+  params.compressionLevel = options.getInt("-compression");
+  CHECK(1 <= params.compressionLevel && params.compressionLevel <= 9, "compression level should be in [1..9]");
+  params.threads = options.getInt("-threads");
+  if (params.threads <= 0) {
+    params.threads = max(int(std::thread::hardware_concurrency()), 1);
+  }
+
   params.modelFile = options.getOption("-o");
   params.resultFile = options.getOption("-result");
+  params.solver = options.getOption("-solver");
+  params.timeout = options.getInt("-timeout");
+  CHECK(params.timeout >= 0, "the time limit cannot be negative");
+  params.lazyTransitivity = options.getBool("-lazy-transitivity");
+  params.cubeDepth = options.getInt("-cubes");
+  CHECK(0 <= params.cubeDepth && params.cubeDepth <= 20, "the number of split variables should be in [0..20]");
+  CHECK(params.solver == "" || (params.modelFile == "" && params.resultFile == ""), "'-solver' cannot be combined with '-o' or '-result'");
+  CHECK(!params.lazyTransitivity || (params.modelFile == "" && params.resultFile == ""), "'-lazy-transitivity' cannot be combined with '-o' or '-result'");
+  CHECK(params.cubeDepth == 0 || (params.modelFile == "" && params.resultFile == ""), "'-cubes' cannot be combined with '-o' or '-result'");
 
   CHECK(params.modelFile == "" || params.resultFile == "", "only one of ['-o', '-result'] can be provided");
+  params.orderFile = options.getOption("-order");
+  CHECK(params.orderFile == "" || (params.modelFile == "" && params.resultFile == ""), "'-order' cannot be combined with '-o' or '-result'");
+  CHECK(params.orderFile == "" || params.isStack() || params.isQueue() || params.isMixed(), "'-order' is supported for stack, queue and mixed layouts");
+  CHECK(params.orderFile == "" || (!params.trees && params.local == 0), "'-order' cannot be combined with '-trees' or '-local'");
+  params.mapFile = options.getOption("-map");
+  if (params.modelFile != "" && params.mapFile == "") {
+    params.mapFile = params.modelFile + ".map";
+  }
+  return params;
+}
+
+// reads the page of every edge: lines of the labels of its vertices and the page
+void readFixedPages(const string& file, const Params& params, InputGraph& inputGraph) {
+  CHECK(params.isStack() || params.isQueue() || params.isMixed(), "'-pages' is supported for stack, queue and mixed layouts");
+  CHECK(!params.trees && params.local == 0, "'-pages' cannot be combined with '-trees' or '-local'");
+  CHECK(params.orderFile == "", "only one of ['-order', '-pages'] can be provided");
 
+  map<pair<int, int>, int> edgeIndex;
+  for (size_t i = 0; i < inputGraph.edges.size(); i++) {
+    edgeIndex[inputGraph.edges[i]] = int(i);
+  }
+  auto findVertex = [&](const string& label) {
+    auto it = inputGraph.label2id.find(label);
+    CHECK(it != inputGraph.label2id.end(), "vertex " + label + " of the pages is not in the graph");
+    return it->second;
+  };
+
+  ifstream in(file);
+  CHECK(in.good(), "cannot open pages file '" + file + "'");
+  inputGraph.fixedPages.assign(inputGraph.edges.size(), -1);
+  string line;
+  while (getline(in, line)) {
+    line = line.substr(0, line.find('#'));
+    if (line.find_first_not_of(" \t\r") == string::npos) continue;
+    istringstream ss(line);
+    string u, v;
+    int page;
+    CHECK(bool(ss >> u >> v >> page), "incorrect line in the pages file: '" + line + "'");
+    int a = findVertex(u);
+    int b = findVertex(v);
+    auto it = edgeIndex.find(make_pair(min(a, b), max(a, b)));
+    CHECK(it != edgeIndex.end(), "edge (" + u + ", " + v + ") of the pages is not in the graph");
+    CHECK(0 <= page && page < params.stacks + params.queues, "page " + to_string(page) + " of edge (" + u + ", " + v + ") is out of range");
+    CHECK(inputGraph.fixedPages[it->second] == -1, "edge (" + u + ", " + v + ") is repeated in the pages");
+    inputGraph.fixedPages[it->second] = page;
+  }
+  for (size_t i = 0; i < inputGraph.edges.size(); i++) {
+    CHECK(inputGraph.fixedPages[i] != -1, "edge " + inputGraph.edge_to_string(int(i)) + " has no page");
+  }
+}
+
+// splits a line of options at whitespace outside of double quotes
+vector<string> splitOptions(const string& line) {
+  vector<string> res;
+  string cur;
+  bool quoted = false;
+  bool empty = true;
+  for (char c : line) {
+    if (c == '"') {
+      quoted = !quoted;
+      empty = false;
+    } else if (!quoted && (c == ' ' || c == '\t' || c == '\r')) {
+      if (!empty) res.push_back(cur);
+      cur = "";
+      empty = true;
+    } else {
+      cur += c;
+      empty = false;
+    }
+  }
+  CHECK(!quoted, "unbalanced quotes in '" + line + "'");
+  if (!empty) res.push_back(cur);
+  return res;
+}
+
+// the parameters of the portfolio configurations: the options of a configuration
+// override the command line, and configuration i gets seed i unless it sets one
+vector<Params> portfolioParams(const CMDOptions& options, int argc, char** argv) {
+  vector<string> lines;
+  string file = options.getOption("-portfolio-file");
+  if (file != "") {
+    ifstream in(file);
+    CHECK(in.good(), "cannot open portfolio file '" + file + "'");
+    string line;
+    while (getline(in, line)) {
+      line = line.substr(0, line.find('#'));
+      if (line.find_first_not_of(" \t\r") == string::npos) continue;
+      lines.push_back(line);
+    }
+    CHECK(!lines.empty(), "empty portfolio file '" + file + "'");
+  } else {
+    lines = DEFAULT_PORTFOLIO;
+  }
+
+  int count = options.getInt("-portfolio");
+  if (count <= 0) {
+    count = int(lines.size());
+  }
+
+  vector<Params> res;
+  for (int i = 0; i < count; i++) {
+    const string& line = lines[i % lines.size()];
+    auto config = CMDOptions::Create();
+    defineCMDOptions(*config);
+    for (auto& option : splitOptions(line)) {
+      config->SetOption(option);
+    }
+    config->SetOption("-seed=" + to_string(i));
+    config->Parse(argc, argv);
+
+    Params params = buildParams(*config);
+    CHECK(params.modelFile == "" && params.resultFile == "", "portfolio runs cannot be combined with '-o' or '-result'");
+    CHECK(params.orderFile == "", "portfolio runs cannot be combined with '-order'");
+    params.name = line.find_first_not_of(" \t") == string::npos ? "default" : line.substr(line.find_first_not_of(" \t"));
+    res.push_back(params);
+  }
+  return res;
+}
+
+void process(const CMDOptions& options, int argc, char** argv) {
+  if (options.getOption("-convert") != "") {
+    convertCnf(options);
+    return;
+  }
+
+	// input
+	IOGraph graph;
+	GraphParser parser;
+	if (!parser.readGraph(options.getOption("-i"), graph)) {
+		string file = options.getOption("-i");
+		if (file.length() == 0) file = "stdin";
+		ERROR("cannot parse input graph from '" + file + "'");
+	}
+
+  // create graph
+  InputGraph inputGraph;
+  inputGraph.nc = (int)graph.nodes.size();
+  for (int i = 0; i < inputGraph.nc; i++) {
+    inputGraph.id2label[i] = graph.nodes[i].id;
+    inputGraph.label2id[graph.nodes[i].id] = i;
+  }
+  for (size_t i = 0; i < graph.edges.size(); i++) {
+  	auto s = graph.getNode(graph.edges[i].source);
+  	auto t = graph.getNode(graph.edges[i].target);
+  	CHECK(s->index != t->index, "Self-edges are not supported");
+
+  	if (s->index < t->index) {
+	    inputGraph.edges.push_back(make_pair(s->index, t->index));
+	    inputGraph.direction.push_back(true);
+	  } else {
+	    inputGraph.edges.push_back(make_pair(t->index, s->index));
+	    inputGraph.direction.push_back(false);
+	  }
+  }
+
+  Params params = buildParams(options);
+  if (options.getOption("-pages") != "") {
+    readFixedPages(options.getOption("-pages"), params, inputGraph);
+  }
   if (params.verbose) {
     if (params.isStack() || params.isQueue() || params.isMixed()) {
       string ps = params.isStack() ? "stacks" : params.isQueue() ? "queues" : "stack+queue";
@@ -98,7 +337,27 @@ void process(const CMDOptions& options) {
     }
   }
 
-	bool res = run(inputGraph, params);
+  vector<Params> configs;
+  bool portfolio = options.getInt("-portfolio") > 0 || options.getOption("-portfolio-file") != "";
+  if (portfolio) {
+    configs = portfolioParams(options, argc, argv);
+  }
+  // a solver exiting early makes the writes of the model fail instead of killing bob; the
+  // disposition is process-wide, so it is changed only when an external solver is used
+  bool external = params.solver != "";
+  for (auto& config : configs) {
+    external |= config.solver != "";
+  }
+  if (external) {
+    signal(SIGPIPE, SIG_IGN);
+  }
+
+	bool res;
+  if (portfolio) {
+    res = runPortfolio(inputGraph, configs);
+  } else {
+    res = run(inputGraph, params);
+  }
 	if (!res) {
 		LOG("layout does not exist");
 	}
@@ -107,10 +366,12 @@ void process(const CMDOptions& options) {
 int main(int argc, char *argv[]) {
 	auto options = CMDOptions::Create();
 
+	killSolversOnSignals();
+
 	int returnCode = 0;
 	try {
 		prepareCMDOptions(argc, argv, *options);
-		process(*options);
+		process(*options, argc, argv);
 	}	catch (int code) {
 		returnCode = code;
 	}
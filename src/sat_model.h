@@ -1,23 +1,40 @@
 #pragma once
 
+#include "common.h"
+#include "dimacs_io.h"
 #include "logging.h"
+#include "sat_solver.h"
 
 #include <sstream>
 #include <fstream>
 #include <string>
 #include <vector>
 #include <map>
-#include <zlib.h>
+#include <initializer_list>
+#include <functional>
+#include <cmath>
+#include <algorithm>
+#include <cstdint>
 
 using namespace std;
 
+// a literal packed into a signed int: +(id + 1) if positive and -(id + 1) otherwise
 struct MVar {
-  int id;
-  bool positive;
+  int lit;
 
-  MVar(int id, bool positive): id(id), positive(positive) {}
+  MVar(int id, bool positive): lit(positive ? id + 1 : -(id + 1)) {}
+
+  int id() const {
+    return (lit > 0 ? lit : -lit) - 1;
+  }
+
+  bool positive() const {
+    return lit > 0;
+  }
 };
 
+// a builder for clauses whose length is known only at runtime;
+// fixed-length clauses are passed to SATModel::addClause directly
 struct MClause {
   vector<MVar> vars;
 
@@ -28,81 +45,137 @@ struct MClause {
     vars.push_back(v1);
   }
 
-  MClause(const MVar& v1, const MVar& v2) {
+  void addVar(const MVar& v1) {
     vars.push_back(v1);
-    vars.push_back(v2);
   }
+};
 
-  MClause(const MVar& v1, const MVar& v2, const MVar& v3) {
-    vars.push_back(v1);
-    vars.push_back(v2);
-    vars.push_back(v3);
-  }
+// families of variables used by the encodings
+enum VarFamily { REL_VARS, PAGE_VARS, ADJ_VARS, TRACK_VARS, SAME_TRACK_VARS, PAGE_TYPE_VARS, NUM_FAMILIES };
 
-  MClause(const MVar& v1, const MVar& v2, const MVar& v3, const MVar& v4) {
-    vars.push_back(v1);
-    vars.push_back(v2);
-    vars.push_back(v3);
-    vars.push_back(v4);
-  }
+// a contiguous block of variables indexed by a pair (i, j); the layout is either
+//   - rectangular: i in [0..rows), j in [0..cols)
+//   - triangular:  0 <= i < j < rows
+//   - square without the diagonal: i != j in [0..rows)
+struct VarBlock {
+  enum Layout { RECTANGULAR, TRIANGULAR, OFF_DIAGONAL };
 
-  MClause(const MVar& v1, const MVar& v2, const MVar& v3, const MVar& v4, const MVar& v5) {
-    vars.push_back(v1);
-    vars.push_back(v2);
-    vars.push_back(v3);
-    vars.push_back(v4);
-    vars.push_back(v5);
-  }
+  Layout layout = RECTANGULAR;
+  // the id of the first variable in the block (-1 if the block is not created)
+  int first = -1;
+  int rows = 0;
+  int cols = 0;
 
-  MClause(const MClause& clause, const MVar& v1) {
-    vars.insert(vars.end(), clause.vars.begin(), clause.vars.end());
-    vars.push_back(v1);
+  VarBlock() {}
+
+  VarBlock(Layout layout, int first, int rows, int cols): layout(layout), first(first), rows(rows), cols(cols) {}
+
+  bool exists() const {
+    return first >= 0;
   }
 
-  MClause(const MClause& clause, const MVar& v1, const MVar& v2) {
-    vars.insert(vars.end(), clause.vars.begin(), clause.vars.end());
-    vars.push_back(v1);
-    vars.push_back(v2);
+  size_t size() const {
+    if (layout == TRIANGULAR) {
+      return size_t(rows) * (rows - 1) / 2;
+    }
+    if (layout == OFF_DIAGONAL) {
+      return size_t(rows) * (rows - 1);
+    }
+    return size_t(rows) * cols;
   }
 
-  MClause(const MClause& clause, const MVar& v1, const MVar& v2, const MVar& v3) {
-    vars.insert(vars.end(), clause.vars.begin(), clause.vars.end());
-    vars.push_back(v1);
-    vars.push_back(v2);
-    vars.push_back(v3);
+  bool contains(int var) const {
+    return exists() && first <= var && size_t(var - first) < size();
   }
 
-  void addVar(const MVar& v1) {
-    vars.push_back(v1);
+  int var(int i, int j) const {
+    DCHECK(exists());
+    DCHECK(0 <= i && i < rows);
+    if (layout == TRIANGULAR) {
+      DCHECK(i < j && j < rows);
+      return first + int(size_t(i) * (2 * rows - i - 1) / 2) + (j - i - 1);
+    }
+    if (layout == OFF_DIAGONAL) {
+      DCHECK(0 <= j && j < rows && i != j);
+      return first + i * (rows - 1) + (j < i ? j : j - 1);
+    }
+    DCHECK(0 <= j && j < cols);
+    return first + i * cols + j;
+  }
+
+  // the inverse of var(i, j)
+  pair<int, int> index(int var) const {
+    DCHECK(contains(var));
+    size_t k = var - first;
+    if (layout == TRIANGULAR) {
+      // the largest i such that row i starts at or before k
+      size_t n = rows;
+      int i = int((2 * n - 1 - sqrt(double(2 * n - 1) * (2 * n - 1) - 8.0 * k)) / 2);
+      i = max(i, 0);
+      while (i > 0 && size_t(i) * (2 * n - i - 1) / 2 > k) i--;
+      while (size_t(i + 1) * (2 * n - i - 2) / 2 <= k) i++;
+      int j = int(k - size_t(i) * (2 * n - i - 1) / 2) + i + 1;
+      return make_pair(i, j);
+    }
+    if (layout == OFF_DIAGONAL) {
+      int i = int(k / (rows - 1));
+      int j = int(k % (rows - 1));
+      return make_pair(i, j < i ? j : j + 1);
+    }
+    return make_pair(int(k / cols), int(k % cols));
   }
 };
 
 class SATModel {
-  vector<MClause> clauses;
+  // literals of all clauses stored contiguously
+  vector<int> literals;
+  // clause i occupies literals[offsets[i]..offsets[i + 1])
+  vector<size_t> offsets;
+  // if set, clauses are passed to the sink instead of being stored
+  ClauseSink* sink = nullptr;
+  size_t numClauses = 0;
   int curId = 0;
+  // values of fixed variables (1 = true, -1 = false, 0 = unknown), indexed by id
+  vector<int8_t> known;
 
- public:
-  // relative order variables
-  map<pair<int, int>, int> relVars;
+  // relative order variables: (i, j) for i < j is true iff node_i < node_j
+  VarBlock relVars;
   // page variables [edge_index][page]
-  map<pair<int, int>, int> pageVars;
-  // same-page variables
-  map<pair<int, int>, int> spVars;
-  // adjacent-vertices variables
-  map<pair<int, int>, int> adjVars;
-  // track variables [node_index][page]
-  map<pair<int, int>, int> trackVars;
-  // same track variables
-  map<pair<int, int>, int> stVars;
-  // page type variables: true=stack, false=queue
-  map<int, int> pageTypeVars;
+  VarBlock pageVars;
+  // same-page variables [edge_index1 < edge_index2], created on first use; they do
+  // not form a block, so they are not a family of the variable map
+  int spEdges = 0;
+  // ids of the created variables in the triangular layout (-1 if not created)
+  vector<int> spIds;
+  size_t spCreated = 0;
+  // emits the clauses linking a new same-page variable to the page variables
+  std::function<void(int, int, const MVar&)> spDefine;
+  // adjacent-vertices variables [node_index1 != node_index2]
+  VarBlock adjVars;
+  // track variables [node_index][track]
+  VarBlock trackVars;
+  // same track variables [node_index1 < node_index2]
+  VarBlock stVars;
+  // page type variables [page]: true=stack, false=queue
+  VarBlock pageTypeVars;
+
+  VarBlock& mutableBlock(VarFamily family) {
+    return const_cast<VarBlock&>(getBlock(family));
+  }
+
+  VarBlock addBlock(VarBlock::Layout layout, int rows, int cols) {
+    VarBlock block(layout, curId, rows, cols);
+    curId += int(block.size());
+    return block;
+  }
 
+ public:
   // solution (provided by an external solver)
-  map<int, bool> externalVars;
+  SatAssignment externalVars;
 
  public:
   SATModel() {
-    clauses.clear();
+    offsets.push_back(0);
     curId = 0;
   }
 
@@ -111,218 +184,387 @@ class SATModel {
     return curId - 1;
   }
 
-  void addClause(MClause c) {
-    clauses.push_back(c);
+  // streams all subsequent clauses to the sink instead of storing them in memory
+  void setSink(ClauseSink* clauseSink) {
+    CHECK(numClauses == 0, "the sink has to be set before adding clauses");
+    sink = clauseSink;
   }
 
-  MVar getRelVar(int i, int j, bool positive) const {
-    CHECK(i != j);
-    pair<int, int> pair;
+  void addClause(std::initializer_list<MVar> clause) {
+    for (auto& v : clause) {
+      literals.push_back(v.lit);
+    }
+    commitClause();
+  }
 
-    if (i < j) {
-      pair = make_pair(i, j);
+  void addClause(const MClause& clause) {
+    for (auto& v : clause.vars) {
+      literals.push_back(v.lit);
+    }
+    commitClause();
+  }
+
+  // fixes the value of a variable by a unit clause; subsequent clauses satisfied by
+  // the known values are skipped and known-false literals are dropped from them
+  void fixVar(const MVar& v) {
+    addClause({v});
+    if (size_t(v.id()) >= known.size()) {
+      known.resize(curId, 0);
+    }
+    if (known[v.id()] == 0) {
+      known[v.id()] = v.positive() ? 1 : -1;
+    }
+  }
+
+  // 1 if the literal is known to be true, -1 if known to be false, 0 otherwise
+  int knownValue(const MVar& v) const {
+    int id = v.id();
+    if (size_t(id) >= known.size() || known[id] == 0) {
+      return 0;
+    }
+    return (known[id] > 0) == v.positive() ? 1 : -1;
+  }
+
+  void commitClause() {
+    size_t start = offsets.back();
+    if (!known.empty()) {
+      size_t end = start;
+      for (size_t i = start; i < literals.size(); i++) {
+        int lit = literals[i];
+        size_t id = size_t(lit > 0 ? lit : -lit) - 1;
+        if (id < known.size() && known[id] != 0) {
+          if ((known[id] > 0) == (lit > 0)) {
+            // satisfied
+            literals.resize(start);
+            return;
+          }
+          continue;
+        }
+        literals[end++] = lit;
+      }
+      literals.resize(end);
+    }
+
+    numClauses++;
+    if (sink != nullptr) {
+      // the tail of the arena is only used as a scratch buffer
+      sink->addClause(literals.data() + start, literals.size() - start);
+      literals.resize(start);
     } else {
-      pair = make_pair(j, i);
+      offsets.push_back(literals.size());
     }
+  }
+
+  // applies func(const int* lits, size_t size) to every clause
+  template <typename F>
+  void forEachClause(F func) const {
+    for (size_t i = 0; i + 1 < offsets.size(); i++) {
+      func(literals.data() + offsets[i], offsets[i + 1] - offsets[i]);
+    }
+  }
 
-    CHECK(relVars.count(pair));
-    int index = (*relVars.find(pair)).second;
-    return MVar(index, i < j ? positive : !positive);
+  void addRelVars(int n) {
+    CHECK(!relVars.exists());
+    relVars = addBlock(VarBlock::TRIANGULAR, n, n);
   }
 
-  void addRelVar(int i, int j) {
-    if (i >= j) {
-      return;
+  MVar getRelVar(int i, int j, bool positive) const {
+    DCHECK(i != j);
+    if (i < j) {
+      return MVar(relVars.var(i, j), positive);
     }
+    return MVar(relVars.var(j, i), !positive);
+  }
 
-    int var = addVar();
-    CHECK(relVars.count(make_pair(i, j)) == 0);
-    relVars[make_pair(i, j)] = var;
+  void addPageVars(int edgeCount, int pageCount) {
+    CHECK(!pageVars.exists());
+    pageVars = addBlock(VarBlock::RECTANGULAR, edgeCount, pageCount);
   }
 
   MVar getPageVar(int edge, int page, bool positive) const {
-    auto pair = make_pair(edge, page);
-    CHECK(pageVars.count(pair));
-    int index = (*pageVars.find(pair)).second;
-    return MVar(index, positive);
+    return MVar(pageVars.var(edge, page), positive);
   }
 
-  void addPageVar(int edge, int page) {
-    int var = addVar();
-    auto pair = make_pair(edge, page);
-    CHECK(pageVars.count(pair) == 0);
-    pageVars[pair] = var;
+  void addPageTypeVars(int pageCount) {
+    CHECK(!pageTypeVars.exists());
+    pageTypeVars = addBlock(VarBlock::RECTANGULAR, pageCount, 1);
   }
 
-  void addPageTypeVar(int page) {
-    int var = addVar();
-    CHECK(pageTypeVars.count(page) == 0);
-    pageTypeVars[page] = var;
+  MVar getPageTypeVar(int page, bool positive) const {
+    return MVar(pageTypeVars.var(page, 0), positive);
   }
 
-  MVar getPageTypeVar(int page, bool positive) const {
-    CHECK(pageTypeVars.count(page));
-    int index = (*pageTypeVars.find(page)).second;
-    return MVar(index, positive);
+  void addTrackVars(int nodeCount, int trackCount) {
+    CHECK(!trackVars.exists());
+    trackVars = addBlock(VarBlock::RECTANGULAR, nodeCount, trackCount);
   }
 
-  MVar getTrackVar(int node, int page, bool positive) const {
-    auto pair = make_pair(node, page);
-    CHECK(trackVars.count(pair));
-    int index = (*trackVars.find(pair)).second;
-    return MVar(index, positive);
+  MVar getTrackVar(int node, int track, bool positive) const {
+    return MVar(trackVars.var(node, track), positive);
   }
 
-  void addTrackVar(int node, int page) {
-    int var = addVar();
-    auto pair = make_pair(node, page);
-    CHECK(trackVars.count(pair) == 0);
-    trackVars[pair] = var;
+  // same-page variables are created by getSamePageVar only for the pairs that are
+  // referenced; define(edge1, edge2, var) is called for every created variable
+  void addSamePageVars(int edgeCount, std::function<void(int, int, const MVar&)> define) {
+    CHECK(spIds.empty(), "same-page variables are already added");
+    spEdges = edgeCount;
+    spIds.assign(size_t(edgeCount) * (edgeCount - 1) / 2, -1);
+    spDefine = define;
   }
 
-  MVar getSamePageVar(int edge1, int edge2, bool positive) const {
-    auto pair = edge1 < edge2 ? make_pair(edge1, edge2) : make_pair(edge2, edge1);
-    CHECK(spVars.count(pair));
-    int index = (*spVars.find(pair)).second;
-    return MVar(index, positive);
+  MVar getSamePageVar(int edge1, int edge2, bool positive) {
+    DCHECK(edge1 != edge2);
+    if (edge1 > edge2) {
+      std::swap(edge1, edge2);
+    }
+    DCHECK(0 <= edge1 && edge2 < spEdges);
+    int& id = spIds[size_t(edge1) * (2 * spEdges - edge1 - 1) / 2 + (edge2 - edge1 - 1)];
+    if (id < 0) {
+      id = addVar();
+      spCreated++;
+      spDefine(edge1, edge2, MVar(id, true));
+    }
+    return MVar(id, positive);
+  }
+
+  // the number of created same-page variables and the number of edge pairs
+  size_t samePageVarCount() const {
+    return spCreated;
+  }
+  size_t samePagePairCount() const {
+    return spIds.size();
   }
 
-  void addSamePageVar(int edge1, int edge2) {
-    int var = addVar();
-    auto pair = edge1 < edge2 ? make_pair(edge1, edge2) : make_pair(edge2, edge1);
-    CHECK(spVars.count(pair) == 0);
-    spVars[pair] = var;
+  void addSameTrackVars(int nodeCount) {
+    CHECK(!stVars.exists());
+    stVars = addBlock(VarBlock::TRIANGULAR, nodeCount, nodeCount);
   }
 
   MVar getSameTrackVar(int node1, int node2, bool positive) const {
-    auto pair = node1 < node2 ? make_pair(node1, node2) : make_pair(node2, node1);
-    CHECK(stVars.count(pair));
-    int index = (*stVars.find(pair)).second;
-    return MVar(index, positive);
+    DCHECK(node1 != node2);
+    return MVar(node1 < node2 ? stVars.var(node1, node2) : stVars.var(node2, node1), positive);
   }
 
-  void addSameTrackVar(int node1, int node2) {
-    CHECK(node1 < node2);
-    int var = addVar();
-    auto pair = make_pair(node1, node2);
-    CHECK(stVars.count(pair) == 0);
-    stVars[pair] = var;
+  void addAdjVars(int nodeCount) {
+    CHECK(!adjVars.exists());
+    adjVars = addBlock(VarBlock::OFF_DIAGONAL, nodeCount, nodeCount);
   }
 
   MVar getAdjVar(int i, int j, bool positive) const {
-    CHECK(i != j);
-    pair<int, int> pair;
-    pair = make_pair(i, j);
-    CHECK(adjVars.count(pair));
-    int index = (*adjVars.find(pair)).second;
-    return MVar(index, positive);
+    return MVar(adjVars.var(i, j), positive);
+  }
+
+  const VarBlock& getBlock(VarFamily family) const {
+    switch (family) {
+      case REL_VARS: return relVars;
+      case PAGE_VARS: return pageVars;
+      case ADJ_VARS: return adjVars;
+      case TRACK_VARS: return trackVars;
+      case SAME_TRACK_VARS: return stVars;
+      case PAGE_TYPE_VARS: return pageTypeVars;
+      default: ERROR("unknown variable family");
+    }
   }
 
-  void addAdjVar(int i, int j) {
-    int var = addVar();
-    CHECK(adjVars.count(make_pair(i, j)) == 0);
-    adjVars[make_pair(i, j)] = var;
-  }
-  void toDimacs(const string& filename) {
-    std::string ext = filename.substr(filename.find_last_of(".") + 1);
-
-    if (ext == "gz") {
-      // zlib
-      std::ostringstream oss;
-      toDimacs(oss);
-      const auto& content = oss.str(); // make it "const auto content = " if there are issues
-      gzFile out = gzopen(filename.c_str(), "wb9");
-      gzwrite(out, content.c_str(), content.length());
-      gzclose(out);
-    } else {
-      // usual route
-      std::ofstream out;
-      out.open(filename);
-      toDimacs(out);
-      out.close();
+  // writes the variable count and the blocks of all families, one per line:
+  //   vars <count>
+  //   block <family> <layout> <first> <rows> <cols>
+  void writeVarMap(std::ostream& out) const {
+    out << "vars " << curId << "\n";
+    for (int f = 0; f < NUM_FAMILIES; f++) {
+      auto& block = getBlock(VarFamily(f));
+      if (block.exists()) {
+        out << "block " << f << " " << int(block.layout) << " " << block.first << " " << block.rows << " " << block.cols << "\n";
+      }
     }
   }
 
-  void toDimacs(std::ostream& out) {
-    int nvars = varCount();
-    out << "p cnf " << nvars << " " << clauseCount() << "\n";
-
-    for (auto& c : clauses) {
-      for (auto& l : c.vars) {
-	      int var = l.id + 1;
-        CHECK(1 <= var && var <= nvars);
-
-        if (l.positive) {
-          out << var << " ";
-        } else {
-          out << "-" << var << " ";
-        }
+  // restores the variable numbering written by writeVarMap; no clauses are created
+  void readVarMap(std::istream& in) {
+    CHECK(curId == 0, "the model already has variables");
+    string key;
+    while (in >> key) {
+      if (key == "vars") {
+        in >> curId;
+        CHECK(!in.fail(), "incorrect variable map");
+      } else if (key == "block") {
+        int family, layout;
+        VarBlock block;
+        in >> family >> layout >> block.first >> block.rows >> block.cols;
+        CHECK(!in.fail(), "incorrect variable map");
+        CHECK(0 <= family && family < NUM_FAMILIES, "incorrect variable family in the map");
+        CHECK(0 <= layout && layout <= VarBlock::OFF_DIAGONAL, "incorrect block layout in the map");
+        block.layout = VarBlock::Layout(layout);
+        mutableBlock(VarFamily(family)) = block;
+      } else {
+        ERROR("unexpected key in the variable map: " + key);
       }
+    }
+    for (int f = 0; f < NUM_FAMILIES; f++) {
+      auto& block = getBlock(VarFamily(f));
+      CHECK(!block.exists() || block.first + block.size() <= size_t(curId), "incorrect variable map");
+    }
+  }
 
-      out << "0\n";
+  // finds the family and the index of a variable; returns NUM_FAMILIES for
+  // auxiliary variables created by addVar()
+  VarFamily findVar(int var, pair<int, int>& index) const {
+    for (int f = 0; f < NUM_FAMILIES; f++) {
+      auto& block = getBlock(VarFamily(f));
+      if (block.contains(var)) {
+        index = block.index(var);
+        return VarFamily(f);
+      }
     }
+    return NUM_FAMILIES;
+  }
+
+  void toDimacs(const string& filename) {
+    CHECK(sink == nullptr, "clauses are not stored in memory");
+    CnfWriter writer(filename);
+    writer.writeHeader(varCount(), clauseCount());
+    forEachClause([&](const int* lits, size_t size) {
+      writer.addClause(lits, size);
+    });
+    writer.finish(varCount(), clauseCount());
   }
 
   std::string fromDimacs(const string& filename) {
-    std::ifstream in;
-    in.open(filename);
-    std::string line;
-    std::string externalResult = "";
+    externalVars.resize(varCount());
+    readAssignment(filename, externalVars);
 
-    while (std::getline(in, line)) {
-      std::istringstream iss(line);
-      char mode;
+    if (externalVars.status == "SATISFIABLE" && externalVars.assignedCount != varCount()) {
+      ERROR("incorrect number of variables in '" + filename + "': " + std::to_string(varCount()) + " != " + std::to_string(externalVars.assignedCount));
+    }
 
-      if (!(iss >> mode)) {
-        break; // hmm
-      }
+    return externalVars.status;
+  }
 
-      if (mode == 's') {
-        // result
-        iss >> externalResult;
-      } else if (mode == 'v') {
-        // var
-        int vv;
-
-        while (iss >> vv) {
-          if (vv > 0) {
-            int id = vv - 1;
-            CHECK(externalVars.find(id) == externalVars.end());
-            externalVars[id] = true;
-          } else if (vv < 0) {
-            int id = -vv - 1;
-            CHECK(externalVars.find(id) == externalVars.end());
-            externalVars[id] = false;
-          }
-        }
-      }
+  // copies the solution of a solver that returned SAT
+  void fromSolver(const SatSolver& solver) {
+    externalVars.resize(varCount());
+    for (int id = 0; id < int(varCount()); id++) {
+      externalVars.assign(solver.val(id + 1));
     }
+    externalVars.status = "SATISFIABLE";
+  }
 
-    in.close();
-    CHECK(externalResult != "");
+  bool value(int id) const {
+    DCHECK(externalVars.isAssigned(id));
+    return externalVars.value(id);
+  }
 
-    if (externalResult == "SATISFIABLE" && externalVars.size() != varCount()) {
-      ERROR("incorrect number of variables in '" + filename + "': " + std::to_string(varCount()) + " != " + std::to_string(externalVars.size()));
-    }
+  bool value(MVar v) const {
+    DCHECK(externalVars.isAssigned(v.id()));
+    return externalVars.value(v.id()) == v.positive();
+  }
 
-    return externalResult;
+  size_t varCount() const {
+	  return curId;
   }
 
-  bool value(int id) {
-    CHECK(externalVars.count(id));
-    return externalVars[id];
+  size_t clauseCount() const {
+    return numClauses;
   }
+};
+
+// Clauses of the pairwise edge encodings generated by a worker thread. The variables of
+// the model are only read; same-page variables (created lazily and numbered in the order
+// of their first use) and new auxiliary variables are referred to by placeholders, which
+// replay() resolves while adding the clauses to the model
+class EdgeClauseBuffer {
+  EdgeClauseBuffer(const EdgeClauseBuffer&);
+  EdgeClauseBuffer& operator = (const EdgeClauseBuffer&);
+
+ public:
+  // placeholders start at firstPlaceholder, which exceeds the variables of the model
+  EdgeClauseBuffer(const SATModel& model, int firstPlaceholder): model(model), firstPlaceholder(firstPlaceholder) {}
 
-  bool value(MVar v) {
-    CHECK(externalVars.count(v.id));
-    return externalVars[v.id] ? v.positive : !v.positive;
+  MVar getRelVar(int i, int j, bool positive) const {
+    return model.getRelVar(i, j, positive);
+  }
+  MVar getPageVar(int edge, int page, bool positive) const {
+    return model.getPageVar(edge, page, positive);
+  }
+  MVar getPageTypeVar(int page, bool positive) const {
+    return model.getPageTypeVar(page, positive);
+  }
+  MVar getSameTrackVar(int node1, int node2, bool positive) const {
+    return model.getSameTrackVar(node1, node2, positive);
+  }
+  int knownValue(const MVar& v) const {
+    return model.knownValue(v);
   }
 
-  size_t varCount() {
-	  return curId;
+  MVar getSamePageVar(int edge1, int edge2, bool positive) {
+    if (edge1 > edge2) {
+      std::swap(edge1, edge2);
+    }
+    if (pairs.empty() || pairs.back() != make_pair(edge1, edge2)) {
+      pairs.push_back(make_pair(edge1, edge2));
+    }
+    return MVar(firstPlaceholder + int(pairs.size()) - 1, positive);
   }
 
-  size_t clauseCount() {
-    return clauses.size();
+  // the variable is created on replay at the same point of the clause sequence
+  int addVar() {
+    pairs.push_back(make_pair(-1, -1));
+    int id = firstPlaceholder + int(pairs.size()) - 1;
+    literals.push_back(0);
+    literals.push_back(id + 1);
+    ends.push_back(literals.size());
+    return id;
   }
+
+  void addClause(std::initializer_list<MVar> clause) {
+    for (auto& v : clause) {
+      literals.push_back(v.lit);
+    }
+    ends.push_back(literals.size());
+  }
+
+  // adds the clauses to the model in the order they were generated and clears the buffer
+  void replay(SATModel& target) {
+    // the variables created for the addVar() placeholders
+    vector<int> created(pairs.size(), -1);
+    MClause clause;
+    size_t start = 0;
+    for (size_t end : ends) {
+      if (literals[start] == 0) {
+        // a new variable
+        created[literals[start + 1] - 1 - firstPlaceholder] = target.addVar();
+        start = end;
+        continue;
+      }
+
+      clause.vars.clear();
+      for (size_t i = start; i < end; i++) {
+        int lit = literals[i];
+        MVar v((lit > 0 ? lit : -lit) - 1, lit > 0);
+        if (v.id() >= firstPlaceholder) {
+          int k = v.id() - firstPlaceholder;
+          if (pairs[k].first < 0) {
+            v = MVar(created[k], v.positive());
+          } else {
+            v = target.getSamePageVar(pairs[k].first, pairs[k].second, v.positive());
+          }
+        }
+        clause.addVar(v);
+      }
+      target.addClause(clause);
+      start = end;
+    }
+    literals.clear();
+    ends.clear();
+    pairs.clear();
+  }
+
+ private:
+  const SATModel& model;
+  int firstPlaceholder;
+  vector<int> literals;
+  // clauses end at these offsets; a new variable is stored as (0, placeholder)
+  vector<size_t> ends;
+  // the edge pairs of the placeholders; (-1, -1) for new variables
+  vector<pair<int, int>> pairs;
 };
@@ -0,0 +1,628 @@
+#include "sat_solver.h"
+#include "logging.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+using namespace std;
+
+namespace {
+
+// the i-th element (from 0) of the Luby sequence 1 1 2 1 1 2 4 ...
+double luby(uint64_t i) {
+  uint64_t size = 1;
+  int seq = 0;
+  while (size < i + 1) {
+    seq++;
+    size = 2 * size + 1;
+  }
+  while (size - 1 != i) {
+    size = (size - 1) >> 1;
+    seq--;
+    i = i % size;
+  }
+  return pow(2.0, seq);
+}
+
+}
+
+void CdclSolver::reserveVars(int varCount) {
+  if (varCount <= numVars) return;
+  watches.resize(2 * size_t(varCount) + 2);
+  assigns.resize(varCount + 1, 0);
+  model.resize(varCount + 1, 0);
+  phases.resize(varCount + 1, -1);
+  level.resize(varCount + 1, 0);
+  reason.resize(varCount + 1, -1);
+  activity.resize(varCount + 1, 0);
+  seen.resize(varCount + 1, 0);
+  heapIndex.resize(varCount + 1, -1);
+  for (int v = numVars + 1; v <= varCount; v++) {
+    if (seed != 0) {
+      activity[v] = 1e-5 * nextRandom();
+    }
+    heapInsert(v);
+  }
+  numVars = varCount;
+}
+
+void CdclSolver::add(int lit) {
+  if (lit != 0) {
+    pending.push_back(lit);
+  } else {
+    addClause(pending.data(), pending.size());
+    pending.clear();
+  }
+}
+
+void CdclSolver::assume(int lit) {
+  assumptions.push_back(lit);
+}
+
+int CdclSolver::val(int lit) const {
+  int v = abs(lit);
+  bool positive = v <= numVars && model[v] > 0;
+  return positive == (lit > 0) ? lit : -lit;
+}
+
+void CdclSolver::addClause(const int* lits, size_t size) {
+  if (inconsistent) return;
+  backtrack(0);
+
+  int maxVar = 0;
+  for (size_t i = 0; i < size; i++) {
+    maxVar = max(maxVar, abs(lits[i]));
+  }
+  reserveVars(maxVar);
+
+  // drop false and duplicate literals, skip satisfied clauses and tautologies
+  vector<int> clause(lits, lits + size);
+  sort(clause.begin(), clause.end(), [](int l, int r) {
+    return abs(l) < abs(r) || (abs(l) == abs(r) && l < r);
+  });
+  size_t j = 0;
+  for (size_t i = 0; i < clause.size(); i++) {
+    int lit = clause[i];
+    if (litValue(lit) == 1) return;
+    if (j > 0 && clause[j - 1] == -lit) return;
+    if (litValue(lit) == -1 || (j > 0 && clause[j - 1] == lit)) continue;
+    clause[j++] = lit;
+  }
+  clause.resize(j);
+
+  if (clause.empty()) {
+    inconsistent = true;
+  } else if (clause.size() == 1) {
+    enqueue(clause[0], -1);
+  } else {
+    attach(storeClause(clause.data(), clause.size(), false));
+  }
+}
+
+void CdclSolver::phase(int lit) {
+  reserveVars(abs(lit));
+  phases[abs(lit)] = lit > 0 ? 1 : -1;
+}
+
+uint32_t CdclSolver::storeClause(const int* lits, size_t size, bool learnt) {
+  ClauseRef c;
+  c.start = uint32_t(arena.size());
+  c.size = uint32_t(size);
+  c.learnt = learnt;
+  c.deleted = false;
+  c.activity = 0;
+  arena.insert(arena.end(), lits, lits + size);
+  clauses.push_back(c);
+  return uint32_t(clauses.size() - 1);
+}
+
+void CdclSolver::attach(uint32_t cr) {
+  const int* lits = &arena[clauses[cr].start];
+  watches[litIndex(lits[0])].push_back(Watch{cr, lits[1]});
+  watches[litIndex(lits[1])].push_back(Watch{cr, lits[0]});
+}
+
+void CdclSolver::enqueue(int lit, int64_t from) {
+  int v = abs(lit);
+  assigns[v] = lit > 0 ? 1 : -1;
+  level[v] = decisionLevel();
+  reason[v] = from;
+  trail.push_back(lit);
+}
+
+int64_t CdclSolver::propagate() {
+  while (qhead < trail.size()) {
+    int falseLit = -trail[qhead++];
+    vector<Watch>& ws = watches[litIndex(falseLit)];
+    size_t i = 0, j = 0;
+    while (i < ws.size()) {
+      Watch w = ws[i++];
+      if (litValue(w.blocker) == 1) {
+        ws[j++] = w;
+        continue;
+      }
+
+      const ClauseRef& c = clauses[w.clause];
+      int* lits = &arena[c.start];
+      if (lits[0] == falseLit) {
+        swap(lits[0], lits[1]);
+      }
+      int first = lits[0];
+      if (first != w.blocker && litValue(first) == 1) {
+        ws[j++] = Watch{w.clause, first};
+        continue;
+      }
+
+      bool found = false;
+      for (uint32_t k = 2; k < c.size; k++) {
+        if (litValue(lits[k]) != -1) {
+          swap(lits[1], lits[k]);
+          watches[litIndex(lits[1])].push_back(Watch{w.clause, first});
+          found = true;
+          break;
+        }
+      }
+      if (found) continue;
+
+      ws[j++] = Watch{w.clause, first};
+      if (litValue(first) == -1) {
+        while (i < ws.size()) {
+          ws[j++] = ws[i++];
+        }
+        ws.resize(j);
+        qhead = trail.size();
+        return w.clause;
+      }
+      enqueue(first, w.clause);
+    }
+    ws.resize(j);
+  }
+  return -1;
+}
+
+// a literal of the learnt clause is redundant if its reason consists of literals
+// already in the clause (or fixed at level 0)
+bool CdclSolver::redundant(int lit) const {
+  int64_t r = reason[abs(lit)];
+  if (r < 0) return false;
+  const ClauseRef& c = clauses[r];
+  const int* lits = &arena[c.start];
+  for (uint32_t k = 1; k < c.size; k++) {
+    int v = abs(lits[k]);
+    if (!seen[v] && level[v] > 0) return false;
+  }
+  return true;
+}
+
+void CdclSolver::analyze(int64_t confl, vector<int>& learnt, int& backLevel) {
+  learnt.clear();
+  learnt.push_back(0);
+  int pathCount = 0;
+  int p = 0;
+  size_t index = trail.size();
+
+  do {
+    ClauseRef& c = clauses[confl];
+    if (c.learnt) bumpClause(uint32_t(confl));
+    const int* lits = &arena[c.start];
+    for (uint32_t k = (p == 0 ? 0 : 1); k < c.size; k++) {
+      int q = lits[k];
+      int v = abs(q);
+      if (!seen[v] && level[v] > 0) {
+        bumpVar(v);
+        seen[v] = 1;
+        if (level[v] >= decisionLevel()) {
+          pathCount++;
+        } else {
+          learnt.push_back(q);
+        }
+      }
+    }
+    while (!seen[abs(trail[--index])]) {}
+    p = trail[index];
+    confl = reason[abs(p)];
+    seen[abs(p)] = 0;
+    pathCount--;
+  } while (pathCount > 0);
+  learnt[0] = -p;
+
+  // minimization
+  vector<int> all(learnt);
+  size_t j = 1;
+  for (size_t i = 1; i < learnt.size(); i++) {
+    if (!redundant(learnt[i])) {
+      learnt[j++] = learnt[i];
+    }
+  }
+  learnt.resize(j);
+  for (int lit : all) {
+    seen[abs(lit)] = 0;
+  }
+
+  backLevel = 0;
+  if (learnt.size() > 1) {
+    size_t maxIndex = 1;
+    for (size_t i = 2; i < learnt.size(); i++) {
+      if (level[abs(learnt[i])] > level[abs(learnt[maxIndex])]) maxIndex = i;
+    }
+    swap(learnt[1], learnt[maxIndex]);
+    backLevel = level[abs(learnt[1])];
+  }
+}
+
+void CdclSolver::backtrack(int toLevel) {
+  if (decisionLevel() <= toLevel) return;
+  for (size_t i = trail.size(); i > size_t(trailLim[toLevel]); i--) {
+    int v = abs(trail[i - 1]);
+    phases[v] = assigns[v];
+    assigns[v] = 0;
+    reason[v] = -1;
+    heapInsert(v);
+  }
+  trail.resize(trailLim[toLevel]);
+  trailLim.resize(toLevel);
+  qhead = trail.size();
+}
+
+int CdclSolver::pickBranch() {
+  if (seed != 0 && !heap.empty() && nextRandom() < 0.01) {
+    int v = heap[size_t(nextRandom() * heap.size())];
+    if (assigns[v] == 0) return v;
+  }
+  while (!heap.empty()) {
+    int v = heapPop();
+    if (assigns[v] == 0) return v;
+  }
+  return 0;
+}
+
+// removes satisfied clauses and half of the learnt clauses; called at level 0
+void CdclSolver::reduceLearnts() {
+  sort(learnts.begin(), learnts.end(), [&](uint32_t l, uint32_t r) {
+    return clauses[l].activity < clauses[r].activity;
+  });
+  for (size_t i = 0; i < learnts.size() / 2; i++) {
+    if (clauses[learnts[i]].size > 2) clauses[learnts[i]].deleted = true;
+  }
+
+  vector<int> newArena;
+  vector<ClauseRef> newClauses;
+  learnts.clear();
+  for (auto& c : clauses) {
+    if (c.deleted) continue;
+    bool satisfied = false;
+    size_t start = newArena.size();
+    for (uint32_t k = 0; k < c.size; k++) {
+      int lit = arena[c.start + k];
+      int val = litValue(lit);
+      if (val == 1) {
+        satisfied = true;
+        break;
+      }
+      if (val == 0) newArena.push_back(lit);
+    }
+    if (satisfied) {
+      newArena.resize(start);
+      continue;
+    }
+    ClauseRef nc = c;
+    nc.start = uint32_t(start);
+    nc.size = uint32_t(newArena.size() - start);
+    if (nc.learnt) learnts.push_back(uint32_t(newClauses.size()));
+    newClauses.push_back(nc);
+  }
+  arena.swap(newArena);
+  clauses.swap(newClauses);
+
+  for (auto& ws : watches) ws.clear();
+  for (uint32_t cr = 0; cr < clauses.size(); cr++) {
+    attach(cr);
+  }
+  for (int lit : trail) {
+    reason[abs(lit)] = -1;
+  }
+}
+
+SatSolver::Result CdclSolver::solve() {
+  Result res = search();
+  assumptions.clear();
+  return res;
+}
+
+SatSolver::Result CdclSolver::search() {
+  if (inconsistent) return UNSAT;
+  backtrack(0);
+  for (int lit : assumptions) reserveVars(abs(lit));
+  if (propagate() != -1) {
+    inconsistent = true;
+    return UNSAT;
+  }
+
+  vector<int> learnt;
+  uint64_t restarts = 0;
+  uint64_t restartLimit = uint64_t(100 * luby(restarts));
+  uint64_t conflictsSinceRestart = 0;
+  size_t maxLearnts = max(clauses.size() / 3, size_t(10000));
+
+  while (true) {
+    int64_t confl = propagate();
+    if (confl != -1) {
+      conflicts++;
+      conflictsSinceRestart++;
+      if (decisionLevel() == 0) {
+        inconsistent = true;
+        return UNSAT;
+      }
+
+      int backLevel;
+      analyze(confl, learnt, backLevel);
+      backtrack(backLevel);
+      if (learnt.size() == 1) {
+        enqueue(learnt[0], -1);
+      } else {
+        uint32_t cr = storeClause(learnt.data(), learnt.size(), true);
+        attach(cr);
+        learnts.push_back(cr);
+        bumpClause(cr);
+        enqueue(learnt[0], cr);
+      }
+      varInc /= 0.95;
+      clauseInc /= 0.999;
+
+      if ((conflicts & 63) == 0 && terminate && terminate()) {
+        backtrack(0);
+        return UNKNOWN;
+      }
+      continue;
+    }
+
+    if (conflictsSinceRestart >= restartLimit) {
+      backtrack(0);
+      if (learnts.size() >= maxLearnts) {
+        reduceLearnts();
+        maxLearnts = size_t(maxLearnts * 1.1);
+      }
+      restarts++;
+      restartLimit = uint64_t(100 * luby(restarts));
+      conflictsSinceRestart = 0;
+      continue;
+    }
+
+    int next = 0;
+    while (size_t(decisionLevel()) < assumptions.size()) {
+      int a = assumptions[decisionLevel()];
+      if (litValue(a) == 1) {
+        trailLim.push_back(int(trail.size()));
+      } else if (litValue(a) == -1) {
+        backtrack(0);
+        return UNSAT;
+      } else {
+        next = a;
+        break;
+      }
+    }
+
+    if (next == 0) {
+      int v = pickBranch();
+      if (v == 0) {
+        for (int u = 1; u <= numVars; u++) model[u] = assigns[u];
+        backtrack(0);
+        return SAT;
+      }
+      next = phases[v] > 0 ? v : -v;
+    }
+    decisions++;
+    trailLim.push_back(int(trail.size()));
+    enqueue(next, -1);
+  }
+}
+
+double CdclSolver::nextRandom() {
+  // xorshift64*
+  randomState ^= randomState >> 12;
+  randomState ^= randomState << 25;
+  randomState ^= randomState >> 27;
+  return double((randomState * 0x2545F4914F6CDD1DULL) >> 11) / double(uint64_t(1) << 53);
+}
+
+void CdclSolver::bumpVar(int v) {
+  if ((activity[v] += varInc) > 1e100) {
+    for (int u = 1; u <= numVars; u++) activity[u] *= 1e-100;
+    varInc *= 1e-100;
+  }
+  if (heapIndex[v] >= 0) heapUp(heapIndex[v]);
+}
+
+void CdclSolver::bumpClause(uint32_t cr) {
+  if ((clauses[cr].activity += float(clauseInc)) > 1e20f) {
+    for (uint32_t l : learnts) clauses[l].activity *= 1e-20f;
+    clauseInc *= 1e-20;
+  }
+}
+
+void CdclSolver::heapInsert(int v) {
+  if (heapIndex[v] >= 0) return;
+  heapIndex[v] = int(heap.size());
+  heap.push_back(v);
+  heapUp(heap.size() - 1);
+}
+
+void CdclSolver::heapUp(size_t i) {
+  int v = heap[i];
+  while (i > 0) {
+    size_t parent = (i - 1) / 2;
+    if (activity[heap[parent]] >= activity[v]) break;
+    heap[i] = heap[parent];
+    heapIndex[heap[i]] = int(i);
+    i = parent;
+  }
+  heap[i] = v;
+  heapIndex[v] = int(i);
+}
+
+void CdclSolver::heapDown(size_t i) {
+  int v = heap[i];
+  while (2 * i + 1 < heap.size()) {
+    size_t child = 2 * i + 1;
+    if (child + 1 < heap.size() && activity[heap[child + 1]] > activity[heap[child]]) child++;
+    if (activity[heap[child]] <= activity[v]) break;
+    heap[i] = heap[child];
+    heapIndex[heap[i]] = int(i);
+    i = child;
+  }
+  heap[i] = v;
+  heapIndex[v] = int(i);
+}
+
+int CdclSolver::heapPop() {
+  int v = heap[0];
+  heapIndex[v] = -1;
+  heap[0] = heap.back();
+  heap.pop_back();
+  if (!heap.empty()) {
+    heapIndex[heap[0]] = 0;
+    heapDown(0);
+  }
+  return v;
+}
+
+void ExternalSolver::add(int lit) {
+  literals.push_back(lit);
+  if (lit == 0) {
+    numClauses++;
+  } else {
+    numVars = max(numVars, abs(lit));
+  }
+}
+
+void ExternalSolver::assume(int lit) {
+  assumptions.push_back(lit);
+  numVars = max(numVars, abs(lit));
+}
+
+namespace {
+
+// the result of an external solver from its parsed output
+SatSolver::Result externalResult(const SatAssignment& solution, int numVars, const string& command) {
+  if (solution.status == "SATISFIABLE") {
+    CHECK(solution.assignedCount == size_t(numVars), "incorrect number of variables in the output of '" + command + "': " +
+          to_string(numVars) + " != " + to_string(solution.assignedCount));
+    return SatSolver::SAT;
+  }
+  if (solution.status == "UNSATISFIABLE") {
+    return SatSolver::UNSAT;
+  }
+  return SatSolver::UNKNOWN;
+}
+
+}
+
+SatSolver::Result ExternalSolver::solve() {
+  SolverProcess process(command);
+  try {
+    CnfWriter writer(process.input(), "the input of '" + command + "'");
+    writer.writeHeader(numVars, numClauses + assumptions.size());
+    size_t start = 0;
+    for (size_t i = 0; i < literals.size(); i++) {
+      if (literals[i] == 0) {
+        writer.addClause(literals.data() + start, i - start);
+        start = i + 1;
+      }
+    }
+    for (int lit : assumptions) {
+      writer.addClause(&lit, 1);
+    }
+    writer.finish(numVars, numClauses + assumptions.size());
+  } catch (int) {
+    process.inputFailed();
+  }
+  assumptions.clear();
+
+  solution.resize(numVars);
+  if (!process.wait(solution, terminate)) {
+    return UNKNOWN;
+  }
+  return externalResult(solution, numVars, command);
+}
+
+int ExternalSolver::val(int lit) const {
+  int v = abs(lit);
+  bool positive = v <= numVars && solution.value(v - 1);
+  return positive == (lit > 0) ? lit : -lit;
+}
+
+StreamingSolver::StreamingSolver(const string& command, int varCount, size_t clauseCount)
+    : command(command), numVars(varCount), numClauses(clauseCount) {
+  process.reset(new SolverProcess(command));
+  writer.reset(new CnfWriter(process->input(), "the input of '" + command + "'"));
+  try {
+    writer->writeHeader(numVars, numClauses);
+  } catch (int) {
+    process->inputFailed();
+  }
+}
+
+void StreamingSolver::add(int lit) {
+  if (lit != 0) {
+    pending.push_back(lit);
+    return;
+  }
+  addClause(pending.data(), pending.size());
+  pending.clear();
+}
+
+void StreamingSolver::addClause(const int* lits, size_t size) {
+  written++;
+  if (cancelled) return;
+  // the solver is stopped without waiting for the rest of the model
+  if ((written & 0xffff) == 0 && terminate && terminate()) {
+    cancelled = true;
+    writer.reset();
+    process.reset();
+    return;
+  }
+  try {
+    writer->addClause(lits, size);
+  } catch (int) {
+    process->inputFailed();
+  }
+}
+
+void StreamingSolver::finish(int varCount, size_t clauseCount) {
+  CHECK(varCount == numVars && clauseCount == numClauses && written == numClauses,
+        "the streamed model does not match the announced header");
+}
+
+SatSolver::Result StreamingSolver::solve() {
+  if (cancelled) {
+    return UNKNOWN;
+  }
+  CHECK(process != nullptr, "a streamed model can be solved only once");
+  try {
+    writer->finish(numVars, numClauses);
+  } catch (int) {
+    process->inputFailed();
+  }
+  solution.resize(numVars);
+  bool finished = process->wait(solution, terminate);
+  writer.reset();
+  process.reset();
+  if (!finished) {
+    return UNKNOWN;
+  }
+  return externalResult(solution, numVars, command);
+}
+
+int StreamingSolver::val(int lit) const {
+  int v = abs(lit);
+  bool positive = v <= numVars && solution.value(v - 1);
+  return positive == (lit > 0) ? lit : -lit;
+}
+
+unique_ptr<SatSolver> createSolver(const string& command, int seed) {
+  if (command == "") {
+    return unique_ptr<SatSolver>(new CdclSolver(uint64_t(seed)));
+  }
+  return unique_ptr<SatSolver>(new ExternalSolver(command));
+}
@@ -0,0 +1,230 @@
+#pragma once
+
+#include "dimacs_io.h"
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <functional>
+#include <cstdint>
+#include <cstddef>
+
+// IPASIR-style interface of an incremental SAT solver. Literals are in the dimacs
+// convention: +v / -v for variables 1..n. The solver is also a sink for the clauses
+// produced by the encoders
+class SatSolver : public ClauseSink {
+ public:
+  enum Result { UNKNOWN = 0, SAT = 10, UNSAT = 20 };
+
+  // adds a literal to the clause under construction; 0 finalizes the clause
+  virtual void add(int lit) = 0;
+  // assumes the literal for the next solve() call
+  virtual void assume(int lit) = 0;
+  // solves the formula under the assumptions, which are cleared afterwards
+  virtual Result solve() = 0;
+  // lit if the literal is true in the last solution and -lit otherwise
+  virtual int val(int lit) const = 0;
+  // the solver checks terminate() periodically and returns UNKNOWN if it is true
+  virtual void setTerminate(std::function<bool()> terminate) = 0;
+  // the preferred value of the variable in the next decisions (a hint only)
+  virtual void phase(int lit) {}
+
+  void addClause(const int* lits, size_t size) override {
+    for (size_t i = 0; i < size; i++) {
+      add(lits[i]);
+    }
+    add(0);
+  }
+};
+
+// A compact CDCL solver: two watched literals, 1UIP learning with clause minimization,
+// VSIDS branching with phase saving, Luby restarts and learnt clause reduction. A non-zero
+// seed randomizes the initial variable order and 1% of the decisions
+class CdclSolver : public SatSolver {
+  CdclSolver(const CdclSolver&);
+  CdclSolver& operator = (const CdclSolver&);
+
+ public:
+  explicit CdclSolver(uint64_t seed = 0): seed(seed), randomState(seed * 0x9E3779B97F4A7C15ULL + 1) {}
+
+  void add(int lit) override;
+  void assume(int lit) override;
+  Result solve() override;
+  int val(int lit) const override;
+  void setTerminate(std::function<bool()> terminate) override {
+    this->terminate = terminate;
+  }
+
+  void addClause(const int* lits, size_t size) override;
+  void finish(int varCount, size_t clauseCount) override {
+    reserveVars(varCount);
+  }
+
+  void phase(int lit) override;
+
+  void reserveVars(int varCount);
+
+  uint64_t conflictCount() const {
+    return conflicts;
+  }
+  uint64_t decisionCount() const {
+    return decisions;
+  }
+
+ private:
+  struct Watch {
+    uint32_t clause;
+    int blocker;
+  };
+
+  // a clause occupies arena[start..start + size)
+  struct ClauseRef {
+    uint32_t start;
+    uint32_t size;
+    bool learnt;
+    bool deleted;
+    float activity;
+  };
+
+  int numVars = 0;
+  bool inconsistent = false;
+  std::vector<int> arena;
+  std::vector<ClauseRef> clauses;
+  std::vector<uint32_t> learnts;
+  std::vector<std::vector<Watch>> watches;
+
+  // the clause under construction and the assumptions of the next call
+  std::vector<int> pending;
+  std::vector<int> assumptions;
+
+  // per variable
+  std::vector<int8_t> assigns;
+  std::vector<int8_t> model;
+  std::vector<int8_t> phases;
+  std::vector<int> level;
+  std::vector<int64_t> reason;
+  std::vector<double> activity;
+  std::vector<char> seen;
+
+  std::vector<int> trail;
+  std::vector<int> trailLim;
+  size_t qhead = 0;
+
+  // binary heap of variables ordered by activity
+  std::vector<int> heap;
+  std::vector<int> heapIndex;
+
+  double varInc = 1.0;
+  double clauseInc = 1.0;
+  uint64_t conflicts = 0;
+  uint64_t decisions = 0;
+  std::function<bool()> terminate;
+  uint64_t seed;
+  uint64_t randomState;
+
+  static size_t litIndex(int lit) {
+    return lit > 0 ? size_t(2 * lit) : size_t(-2 * lit + 1);
+  }
+  int litValue(int lit) const {
+    int8_t v = assigns[lit > 0 ? lit : -lit];
+    return lit > 0 ? v : -v;
+  }
+  int decisionLevel() const {
+    return int(trailLim.size());
+  }
+
+  Result search();
+  uint32_t storeClause(const int* lits, size_t size, bool learnt);
+  void attach(uint32_t cr);
+  void enqueue(int lit, int64_t from);
+  int64_t propagate();
+  void analyze(int64_t confl, std::vector<int>& learnt, int& backLevel);
+  bool redundant(int lit) const;
+  void backtrack(int toLevel);
+  int pickBranch();
+  void reduceLearnts();
+  // uniform in [0, 1)
+  double nextRandom();
+
+  void bumpVar(int v);
+  void bumpClause(uint32_t cr);
+  void heapInsert(int v);
+  void heapUp(size_t i);
+  void heapDown(size_t i);
+  int heapPop();
+};
+
+// Runs an external solver on every solve() call: the clauses are kept in memory and
+// piped to its stdin together with the assumptions as unit clauses. The solver process
+// is killed when terminate() becomes true
+class ExternalSolver : public SatSolver {
+  ExternalSolver(const ExternalSolver&);
+  ExternalSolver& operator = (const ExternalSolver&);
+
+ public:
+  explicit ExternalSolver(const std::string& command): command(command) {}
+
+  void add(int lit) override;
+  void assume(int lit) override;
+  Result solve() override;
+  int val(int lit) const override;
+  void setTerminate(std::function<bool()> terminate) override {
+    this->terminate = terminate;
+  }
+
+  void finish(int varCount, size_t clauseCount) override {
+    numVars = std::max(numVars, varCount);
+  }
+
+ private:
+  std::string command;
+  int numVars = 0;
+  // literals of all clauses, each terminated by 0
+  std::vector<int> literals;
+  size_t numClauses = 0;
+  std::vector<int> assumptions;
+  SatAssignment solution;
+  std::function<bool()> terminate;
+};
+
+// Streams the clauses to the stdin of an external solver while they are generated. The
+// header comes first, so the counts have to be known in advance (e.g. from a counting
+// pass over the same encoding); supports a single solve() call without assumptions
+class StreamingSolver : public SatSolver {
+  StreamingSolver(const StreamingSolver&);
+  StreamingSolver& operator = (const StreamingSolver&);
+
+ public:
+  StreamingSolver(const std::string& command, int varCount, size_t clauseCount);
+
+  void add(int lit) override;
+  void assume(int lit) override {
+    ERROR("assumptions are not supported by a streamed model");
+  }
+  Result solve() override;
+  int val(int lit) const override;
+  void setTerminate(std::function<bool()> terminate) override {
+    this->terminate = terminate;
+  }
+
+  void addClause(const int* lits, size_t size) override;
+  void finish(int varCount, size_t clauseCount) override;
+
+ private:
+  std::string command;
+  int numVars;
+  size_t numClauses;
+  size_t written = 0;
+  // whether terminate() stopped the solver while the model was streamed
+  bool cancelled = false;
+  std::unique_ptr<SolverProcess> process;
+  std::unique_ptr<CnfWriter> writer;
+  std::vector<int> pending;
+  SatAssignment solution;
+  std::function<bool()> terminate;
+};
+
+// the bundled solver if the command is empty and an external one otherwise; the seed
+// applies to the bundled solver
+std::unique_ptr<SatSolver> createSolver(const std::string& command, int seed = 0);
@@ -151,14 +151,14 @@ void encodeTrees(SATModel& model, InputGraph& inputGraph, Params& params) {
       int en1 = inputGraph.edges[j].first;
       int en2 = inputGraph.edges[j].second;
       //when an edge i is not on page page j, then both father  variables are false
-      model.addClause(MClause(model.getPageVar(j, page, true), MVar(firstVarFather[page] + (2 * j), false)));
-      model.addClause(MClause(model.getPageVar(j, page, true), MVar(firstVarFather[page] + (2 * j) + 1, false)));
+      model.addClause({model.getPageVar(j, page, true), MVar(firstVarFather[page] + (2 * j), false)});
+      model.addClause({model.getPageVar(j, page, true), MVar(firstVarFather[page] + (2 * j) + 1, false)});
       //when an edge is on page j, than exactly one father variable has to be true
-      model.addClause(MClause(model.getPageVar(j, page, false), MVar(firstVarFather[page] + (2 * j), true), MVar(firstVarFather[page] + (2 * j) + 1, true)));
-      model.addClause(MClause(model.getPageVar(j, page, false), MVar(firstVarFather[page] + (2 * j), false), MVar(firstVarFather[page] + (2 * j) + 1, false)));
+      model.addClause({model.getPageVar(j, page, false), MVar(firstVarFather[page] + (2 * j), true), MVar(firstVarFather[page] + (2 * j) + 1, true)});
+      model.addClause({model.getPageVar(j, page, false), MVar(firstVarFather[page] + (2 * j), false), MVar(firstVarFather[page] + (2 * j) + 1, false)});
       //if any node has a father it cannot be the root in tree k
-      model.addClause(MClause(MVar(firstVarFather[page] + (2 * j), false), MVar(firstVarRoot + (en2 * pageCount) + page, false)));
-      model.addClause(MClause(MVar(firstVarFather[page] + (2 * j) + 1, false), MVar(firstVarRoot + (en1 * pageCount) + page, false)));
+      model.addClause({MVar(firstVarFather[page] + (2 * j), false), MVar(firstVarRoot + (en2 * pageCount) + page, false)});
+      model.addClause({MVar(firstVarFather[page] + (2 * j) + 1, false), MVar(firstVarRoot + (en1 * pageCount) + page, false)});
     }
   }
 
@@ -240,24 +240,24 @@ void encodeTrees(SATModel& model, InputGraph& inputGraph, Params& params) {
       int en1 = inputGraph.edges[j].first;
       int en2 = inputGraph.edges[j].second;
       //if a is father of b, then a is ancestor of b as well
-      model.addClause(MClause(MVar(firstVarFather[i] + (2 * j), false), MVar(firstVarAncestor[i] + (en1 * n) + en2, true)));
-      model.addClause(MClause(MVar(firstVarFather[i] + (2 * j) + 1, false), MVar(firstVarAncestor[i] + (en2 * n) + en1, true)));
+      model.addClause({MVar(firstVarFather[i] + (2 * j), false), MVar(firstVarAncestor[i] + (en1 * n) + en2, true)});
+      model.addClause({MVar(firstVarFather[i] + (2 * j) + 1, false), MVar(firstVarAncestor[i] + (en2 * n) + en1, true)});
     }
 
     //transitivity of ancestor relation
     for (int j = 0; j < n; j++) {
       for (int k = j + 1; k < n; k++) {
         for (int l = k + 1; l < n; l++) {
-          model.addClause(MClause(MVar(firstVarAncestor[i] + (j * n) + k, false), MVar(firstVarAncestor[i] + (k * n) + l, false), MVar(firstVarAncestor[i] + (j * n) + l, true)));
-          model.addClause(MClause(MVar(firstVarAncestor[i] + (j * n) + l, false), MVar(firstVarAncestor[i] + (l * n) + k, false), MVar(firstVarAncestor[i] + (j * n) + k, true)));
-          model.addClause(MClause(MVar(firstVarAncestor[i] + (k * n) + j, false), MVar(firstVarAncestor[i] + (j * n) + l, false), MVar(firstVarAncestor[i] + (k * n) + l, true)));
-          model.addClause(MClause(MVar(firstVarAncestor[i] + (k * n) + l, false), MVar(firstVarAncestor[i] + (l * n) + j, false), MVar(firstVarAncestor[i] + (k * n) + j, true)));
-          model.addClause(MClause(MVar(firstVarAncestor[i] + (l * n) + j, false), MVar(firstVarAncestor[i] + (j * n) + k, false), MVar(firstVarAncestor[i] + (l * n) + k, true)));
-          model.addClause(MClause(MVar(firstVarAncestor[i] + (l * n) + k, false), MVar(firstVarAncestor[i] + (k * n) + j, false), MVar(firstVarAncestor[i] + (l * n) + j, true)));
+          model.addClause({MVar(firstVarAncestor[i] + (j * n) + k, false), MVar(firstVarAncestor[i] + (k * n) + l, false), MVar(firstVarAncestor[i] + (j * n) + l, true)});
+          model.addClause({MVar(firstVarAncestor[i] + (j * n) + l, false), MVar(firstVarAncestor[i] + (l * n) + k, false), MVar(firstVarAncestor[i] + (j * n) + k, true)});
+          model.addClause({MVar(firstVarAncestor[i] + (k * n) + j, false), MVar(firstVarAncestor[i] + (j * n) + l, false), MVar(firstVarAncestor[i] + (k * n) + l, true)});
+          model.addClause({MVar(firstVarAncestor[i] + (k * n) + l, false), MVar(firstVarAncestor[i] + (l * n) + j, false), MVar(firstVarAncestor[i] + (k * n) + j, true)});
+          model.addClause({MVar(firstVarAncestor[i] + (l * n) + j, false), MVar(firstVarAncestor[i] + (j * n) + k, false), MVar(firstVarAncestor[i] + (l * n) + k, true)});
+          model.addClause({MVar(firstVarAncestor[i] + (l * n) + k, false), MVar(firstVarAncestor[i] + (k * n) + j, false), MVar(firstVarAncestor[i] + (l * n) + j, true)});
         }
 
         //antisymmetric relation
-        model.addClause(MClause(MVar(firstVarAncestor[i] + (j * n) + k, false), MVar(firstVarAncestor[i] + (k * n) + j, false)));
+        model.addClause({MVar(firstVarAncestor[i] + (j * n) + k, false), MVar(firstVarAncestor[i] + (k * n) + j, false)});
       }
     }
 
@@ -268,14 +268,14 @@ void encodeTrees(SATModel& model, InputGraph& inputGraph, Params& params) {
           continue;
         }
 
-        model.addClause(MClause(MVar(firstVarRoot + (j * pageCount) + i, false), MVar(firstVarAncestor[i] + (k * n) + j, false)));
+        model.addClause({MVar(firstVarRoot + (j * pageCount) + i, false), MVar(firstVarAncestor[i] + (k * n) + j, false)});
       }
     }
 
     //for every page only trees: number of roots=1
     for (int j = 0; j < n; j++) {
       for (int k = j + 1; k < n; k++) {
-        model.addClause(MClause(MVar(firstVarRoot + (j * pageCount) + i, false), MVar(firstVarRoot + (k * pageCount) + i, false)));
+        model.addClause({MVar(firstVarRoot + (j * pageCount) + i, false), MVar(firstVarRoot + (k * pageCount) + i, false)});
       }
     }
   }
@@ -313,10 +313,10 @@ void encodeAltTrees(SATModel& model, InputGraph& inputGraph, int pageCount) {
 
       if (colors[i] == 0) {
         CHECK(colors[i] == 0 && colors[other] == 1);
-        model.addClause(MClause(model.getPageVar(j, 0, false), model.getRelVar(i, other, true)));
+        model.addClause({model.getPageVar(j, 0, false), model.getRelVar(i, other, true)});
       } else {
         CHECK(colors[i] == 1 && colors[other] == 0);
-        model.addClause(MClause(model.getPageVar(j, 1, false), model.getRelVar(i, other, true)));
+        model.addClause({model.getPageVar(j, 1, false), model.getRelVar(i, other, true)});
       }
     }
   }
@@ -332,11 +332,11 @@ void encodeSeparatingDecomposition(SATModel& model, InputGraph& inputGraph, Para
   CHECK(s != t);
   for (auto& ns : inputGraph.planar_edges[s]) {
     int e_index = inputGraph.findEdgeIndex(s, ns);
-    model.addClause( MClause(model.getPageVar(e_index, 0, true)) );
+    model.addClause({model.getPageVar(e_index, 0, true)});
   }
   for (auto& ns : inputGraph.planar_edges[t]) {
     int e_index = inputGraph.findEdgeIndex(t, ns);
-    model.addClause( MClause(model.getPageVar(e_index, 1, true)) );
+    model.addClause({model.getPageVar(e_index, 1, true)});
   }*/
   int n = inputGraph.nc;
 
@@ -354,8 +354,8 @@ void encodeSeparatingDecomposition(SATModel& model, InputGraph& inputGraph, Para
       for (size_t i2 = i1 + 1; i2 < edges.size(); i2++) {
         for (size_t i3 = i2 + 1; i3 < edges.size(); i3++) {
           for (size_t i4 = i3 + 1; i4 < edges.size(); i4++) {
-            model.addClause(MClause(model.getPageVar(edges[i1], 0, false), model.getPageVar(edges[i2], 1, false), model.getPageVar(edges[i3], 0, false), model.getPageVar(edges[i4], 1, false)));
-            model.addClause(MClause(model.getPageVar(edges[i1], 1, false), model.getPageVar(edges[i2], 0, false), model.getPageVar(edges[i3], 1, false), model.getPageVar(edges[i4], 0, false)));
+            model.addClause({model.getPageVar(edges[i1], 0, false), model.getPageVar(edges[i2], 1, false), model.getPageVar(edges[i3], 0, false), model.getPageVar(edges[i4], 1, false)});
+            model.addClause({model.getPageVar(edges[i1], 1, false), model.getPageVar(edges[i2], 0, false), model.getPageVar(edges[i3], 1, false), model.getPageVar(edges[i4], 0, false)});
           }
         }
       }
@@ -386,10 +386,10 @@ void encodeStarConstraints(SATModel& model, InputGraph& inputGraph, Params& para
         int e2 = inputGraph.findEdgeIndex(v, w);
 
         // star
-        model.addClause(MClause(model.getRelVar(u, v, false), model.getRelVar(v, w, false), model.getSamePageVar(e1, e2, false)));
-        model.addClause(MClause(model.getRelVar(w, v, false), model.getRelVar(v, u, false), model.getSamePageVar(e1, e2, false)));
+        model.addClause({model.getRelVar(u, v, false), model.getRelVar(v, w, false), model.getSamePageVar(e1, e2, false)});
+        model.addClause({model.getRelVar(w, v, false), model.getRelVar(v, u, false), model.getSamePageVar(e1, e2, false)});
         // forward
-        model.addClause(MClause(model.getRelVar(u, v, false), model.getRelVar(w, v, false), model.getSamePageVar(e1, e2, false)));
+        model.addClause({model.getRelVar(u, v, false), model.getRelVar(w, v, false), model.getSamePageVar(e1, e2, false)});
       }
     }
   }
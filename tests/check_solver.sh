@@ -0,0 +1,78 @@
+#!/bin/sh
+# Runs bob with the stand-in solver through the pipes of '-solver': check_solver.sh [bob]
+# A single stack of the graph has a layout with all variables true (the identity order).
+
+bob=${1:-./bob}
+stub="sh $(dirname "$0")/stub_solver.sh"
+tmp=$(mktemp -d)
+trap 'rm -rf "$tmp"' EXIT
+
+printf 'graph {\n  1 -- 2;\n  2 -- 3;\n  1 -- 3;\n  3 -- 4;\n}\n' > "$tmp/graph.dot"
+# the heuristic and the reductions would find the layout without the solver
+run="$bob -i=$tmp/graph.dot -stacks=1 -heuristic=0 -kernelize=false -decompose=false"
+failed=0
+
+check() {
+  name=$1
+  shift
+  if "$@" > "$tmp/log" 2>&1; then
+    echo "ok    $name"
+  else
+    echo "FAIL  $name"
+    cat "$tmp/log"
+    failed=1
+  fi
+}
+
+# true if the process of the pid file is gone within a second; a killed process whose
+# parent exited may stay a zombie, as it is not necessarily reaped
+stopped() {
+  tries=0
+  while ps -o stat= -p "$(cat "$1")" | grep -q "^[^Z]"; do
+    [ $tries -eq 10 ] && return 1
+    sleep 0.1
+    tries=$((tries + 1))
+  done
+}
+
+streamed_sat() {
+  $run "-solver=$stub sat" > "$tmp/out" 2>&1 && grep -q "page 0:" "$tmp/out"
+}
+
+written_sat() {
+  $run -lazy-transitivity "-solver=$stub sat" > "$tmp/out" 2>&1 && grep -q "page 0:" "$tmp/out"
+}
+
+unsat() {
+  $run "-solver=$stub unsat" > "$tmp/out" 2>&1 && grep -q "layout does not exist" "$tmp/out"
+}
+
+missing_solver() {
+  ! $run "-solver=$tmp/missing" > "$tmp/out" 2>&1 && grep -q "cannot run the solver" "$tmp/out"
+}
+
+timeout_kill() {
+  $run -timeout=1 "-solver=$stub hang $tmp/timeout.pid" > "$tmp/out" 2>&1
+  [ $? -eq 124 ] && stopped "$tmp/timeout.pid"
+}
+
+signal_kill() {
+  $run "-solver=$stub hang $tmp/signal.pid" > "$tmp/out" 2>&1 &
+  pid=$!
+  tries=0
+  while [ ! -s "$tmp/signal.pid" ] && [ $tries -lt 50 ]; do
+    sleep 0.1
+    tries=$((tries + 1))
+  done
+  kill -TERM $pid
+  wait $pid
+  [ -s "$tmp/signal.pid" ] && stopped "$tmp/signal.pid"
+}
+
+check "streamed model, satisfiable" streamed_sat
+check "written model, satisfiable" written_sat
+check "unsatisfiable" unsat
+check "solver cannot be run" missing_solver
+check "solver killed on timeout" timeout_kill
+check "solver killed with bob" signal_kill
+exit $failed
@@ -0,0 +1,28 @@
+#!/bin/sh
+# A stand-in for an external SAT solver, reading the model from stdin:
+#   stub_solver.sh sat           sets all variables to true
+#   stub_solver.sh unsat         reports an unsatisfiable model
+#   stub_solver.sh hang <file>   writes its pid to the file and sleeps until it is killed
+# A model with fewer clauses than announced in its header gets no answer.
+
+if [ "$1" = hang ]; then
+  echo $$ > "$2"
+  exec sleep 60
+fi
+
+awk -v mode="$1" '
+  /^p cnf/ { vars = $3; clauses = $4; next }
+  /^c/ { next }
+  { for (i = 1; i <= NF; i++) if ($i == "0") count++ }
+  END {
+    if (count != clauses) exit 1
+    if (mode == "unsat") {
+      print "s UNSATISFIABLE"
+      exit 20
+    }
+    print "s SATISFIABLE"
+    printf "v"
+    for (i = 1; i <= vars; i++) printf " %d", i
+    print " 0"
+    exit 10
+  }'